@@ -136,6 +136,24 @@ const uint8_t block_bitmap_shaded[] = {
     0x81, 0x66, 0x66, 0x66, 0x81,  
     0xFF, 0xC3, 0x99, 0xC3, 0xFF  
 };
+const uint8_t capsule_bitmap_expand[] = {
+    0x7E, // -XXXXXX-
+    0xDB, // XX-XX-XX
+    0xDB, // XX-XX-XX
+    0x7E  // -XXXXXX-
+};
+const uint8_t capsule_bitmap_life[] = {
+    0x7E, // -XXXXXX-
+    0xE7, // XXX--XXX
+    0xE7, // XXX--XXX
+    0x7E  // -XXXXXX-
+};
+const uint8_t capsule_bitmap_multi[] = {
+    0x7E, // -XXXXXX-
+    0xB5, // X-XX-X-X
+    0xAD, // X-X-XX-X
+    0x7E  // -XXXXXX-
+};
 const uint8_t block_animation_frame_1[] = {
     0xFF, 0x81, 0x81, 0x81, 0xFF
 };
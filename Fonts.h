@@ -23,6 +23,9 @@ extern const uint8_t block_bitmap_stone[];          ///< Bitmap for stone block.
 extern const uint8_t block_bitmap_steel[];          ///< Bitmap for steel block.
 extern const uint8_t block_bitmap_wood[];           ///< Bitmap for wood block.
 extern const uint8_t block_bitmap_shaded[];         ///< Bitmap for shaded block.
+extern const uint8_t capsule_bitmap_expand[];       ///< Power-up capsule: paddle expansion.
+extern const uint8_t capsule_bitmap_life[];         ///< Power-up capsule: extra life.
+extern const uint8_t capsule_bitmap_multi[];        ///< Power-up capsule: multiball.
 extern const uint8_t block_animation_frame_1[];     ///< Animation frame 1 for blocks.
 extern const uint8_t block_animation_frame_2[];     ///< Animation frame 2 for blocks.
 extern const uint8_t block_animation_frame_3[];     ///< Animation frame 3 for blocks.
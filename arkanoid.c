@@ -1,171 +1,825 @@
 #include "arkanoid.h"
 #include "maps.h"
+#include "powerup.h"
+#include "event_queue.h"
+#include "mapgen.h"
 #include <stdbool.h>
 #include <stdlib.h> 
+#include <string.h>
+#ifdef ARKANOID_HOST
+#include <assert.h>
+#endif
+
+// Block state of a map
+typedef struct {
+    uint8_t cells[BLOCK_CELLS_SIZE];    // Packed block types
+    uint16_t rows[MAP_HEIGHT];          // Active block bitmask for each row
+    uint8_t remaining;                  // Number of destructible blocks
+} BlockMap;
+
+// The live map and the staging buffer the next map is decoded into ahead of time
+static BlockMap block_maps[2];
+static BlockMap* live_map = &block_maps[0];
+static BlockMap* staged = &block_maps[1];
+static int16_t staged_map = -1; // Index of the map in the staging buffer, -1 if none
 
 // Global variables
-Block blocks[NUM_BLOCKS];
+uint8_t* block_cells = block_maps[0].cells;
+uint16_t* block_rows = block_maps[0].rows;
+uint8_t block_damage[BLOCK_CELLS_SIZE];
+uint8_t blocks_remaining = 0;
 int current_score = 0;
 int current_map = 0;
 int game_speed = 40;
 int lives = MAX_LIVES;
-static bool ball_is_reset = false; // Restrict scope to this file
+GameState game_state = GAME_STATE_PLAY;
+uint32_t game_seed = 0;
+uint8_t ball_speed = BALL_SPEED_DEFAULT;
+uint8_t view_top = 0;
+uint8_t view_first_row = 0;
+static uint32_t serve_time; // Time the current serve started, in ms
 
 // Score values for block types
 #define SCORE_BLOCK_TYPE_1 10
 #define SCORE_BLOCK_TYPE_2 20
 #define SCORE_BLOCK_TYPE_3 30
 #define SCORE_BLOCK_TYPE_4 40
+#define SCORE_BLOCK_WOOD 30
+#define SCORE_BLOCK_STONE 50
+
+// Hits each block type takes
+const uint8_t block_hits[BLOCK_TYPE_COUNT] = {
+    1, 1, 1, 1, 1, 1,       // BLOCK_TYPE_1 to BLOCK_TYPE_6
+    3,                      // BLOCK_TYPE_STONE
+    BLOCK_INDESTRUCTIBLE,   // BLOCK_TYPE_STEEL
+    2,                      // BLOCK_TYPE_WOOD
+    1                       // BLOCK_TYPE_SHADED
+};
+
+// Hits a block of the given type takes; types past the table break at once
+static uint8_t type_hits(uint8_t type) {
+    return (type < BLOCK_TYPE_COUNT) ? block_hits[type] : 1;
+}
+
+// Read the type nibble of a cell in packed map data
+static uint8_t cell_type(const uint8_t* cells, uint8_t index) {
+    uint8_t cell = cells[index >> 1];
+    return (index & 1) ? (uint8_t)(cell >> 4) : (uint8_t)(cell & 0x0F);
+}
+
+// Read the type nibble of a map cell
+uint8_t block_get_type(uint8_t index) {
+    return cell_type(block_cells, index);
+}
+
+// Write the type nibble of a cell in packed map data
+static void cell_set_type(uint8_t* cells, uint8_t index, uint8_t type) {
+    uint8_t* cell = &cells[index >> 1];
+    if (index & 1) {
+        *cell = (uint8_t)((*cell & 0x0F) | (type << 4));
+    } else {
+        *cell = (uint8_t)((*cell & 0xF0) | (type & 0x0F));
+    }
+}
 
-// Convert an integer map to a Block map
-void convert_map(const int map[MAP_HEIGHT][MAP_WIDTH]) {
-    const int y_offset = 10; // Offset of 10px from the top edge
-    for (int i = 0; i < MAP_HEIGHT; i++) {
-        for (int j = 0; j < MAP_WIDTH; j++) {
-            int index = i * MAP_WIDTH + j;
-            blocks[index].x = (uint8_t)(j * (BLOCK_WIDTH + 1)); // Explicit cast
-            blocks[index].y = (uint8_t)(i * (BLOCK_HEIGHT + 1) + y_offset); // Explicit cast
-            blocks[index].type = (BlockType)map[i][j];
-            blocks[index].is_active = (map[i][j] != 0); // Bloki z typem 0 s nieaktywne
+// Write the type nibble of a map cell
+void block_set_type(uint8_t index, uint8_t type) {
+    cell_set_type(block_cells, index, type);
+}
+
+// Put one block of a decoded map into a block state
+static void decode_block(BlockMap* dst, uint8_t row, uint8_t col, uint8_t type) {
+    if (type == 0) {
+        return; // Bloki z typem 0 s nieaktywne
+    }
+    cell_set_type(dst->cells, BLOCK_INDEX(row, col), type);
+    dst->rows[row] |= BLOCK_ROW_BIT(col);
+    if (type_hits(type) != BLOCK_INDESTRUCTIBLE) {
+        dst->remaining++; // Only these have to go for the map to be cleared
+    }
+}
+
+// Decode a packed map record into a block state
+static void decode_map(BlockMap* dst, const uint8_t* map) {
+    uint8_t width = MAP_RECORD_WIDTH(map);
+    uint8_t height = MAP_RECORD_HEIGHT(map);
+
+    memset(dst, 0, sizeof(*dst));
+    if (map[0] == MAP_FORMAT_SPARSE) {
+        // Only the listed blocks
+        const uint8_t* entry = &map[3];
+        for (uint8_t n = map[2]; n > 0; n--, entry += 2) {
+            decode_block(dst, entry[0] / MAP_WIDTH, entry[0] % MAP_WIDTH, entry[1]);
+        }
+    } else {
+        // Every cell of the bounding box, two per byte
+        const uint8_t* cells = &map[2];
+        uint8_t index = 0;
+        for (uint8_t i = 0; i < height; i++) {
+            for (uint8_t j = 0; j < width; j++, index++) {
+                decode_block(dst, i, j, cell_type(cells, index));
+            }
         }
     }
 }
 
+// Load a packed map into the live block state
+void convert_map(const uint8_t* map) {
+    decode_map(live_map, map);
+    blocks_remaining = live_map->remaining;
+    memset(block_damage, 0, sizeof(block_damage));
+}
+
+// Packed record of a level: a predefined map, or one generated into the buffer
+static const uint8_t* map_record(int level, uint8_t* buffer) {
+    if (level < NUM_MAPS) {
+        return &maps_data[maps_offset[level]];
+    }
+    uint8_t generated = (uint8_t)(level - NUM_MAPS);
+    mapgen_build(buffer, game_seed, generated, generated / MAPGEN_LEVELS_PER_STEP);
+    return buffer;
+}
+
+// Index of the level after the last one played
+static int next_level(void) {
+    return (current_map >= NUM_LEVELS) ? NUM_MAPS : current_map; // Keep generating
+}
+
 // Load the next map
 void load_next_map(void) {
-    if (current_map >= NUM_MAPS) {
-        current_map = 0; // Restart from the first map
+    uint8_t record[MAPGEN_RECORD_SIZE];
+
+    current_map = next_level();
+    if (staged_map == current_map) {
+        // Already decoded: make the staging buffer live
+        BlockMap* map = staged;
+        staged = live_map;
+        live_map = map;
+        block_cells = map->cells;
+        block_rows = map->rows;
+        blocks_remaining = map->remaining;
+        memset(block_damage, 0, sizeof(block_damage));
+    } else {
+        convert_map(map_record(current_map, record));
     }
-    convert_map(maps[current_map]);
+    staged_map = -1;
     current_map++;
 }
 
+// Drop the blocks missing from a saved game's row masks
+void block_keep_rows(const uint16_t* rows) {
+    for (uint8_t row = 0; row < MAP_HEIGHT; row++) {
+        for (uint16_t bits = block_rows[row] & (uint16_t)~rows[row]; bits; bits &= bits - 1) {
+            uint8_t index = BLOCK_INDEX(row, BLOCK_ROW_FIRST(bits));
+            if (type_hits(block_get_type(index)) != BLOCK_INDESTRUCTIBLE) {
+                blocks_remaining--;
+            }
+            block_set_type(index, 0);
+        }
+        block_rows[row] &= rows[row];
+    }
+}
+
+// Decode the next map while the game has time to spare
+void map_prepare(void) {
+    uint8_t record[MAPGEN_RECORD_SIZE];
+    int next = next_level();
+
+    if (staged_map != next) {
+        decode_map(staged, map_record(next, record));
+        staged_map = (int16_t)next;
+    }
+}
+
 // Reset ball position
 void reset_ball(Ball* ball, Paddle* paddle) {
-    ball->x = paddle->x + PADDLE_WIDTH / 2 - BALL_SIZE / 2;
+    ball->x = paddle->x + paddle->width / 2 - BALL_SIZE / 2;
     ball->y = paddle->y - BALL_SIZE - 1;
     ball->dx = 0; // Stop horizontal movement
     ball->dy = 0; // Stop vertical movement
-    ball_is_reset = true;
+    ball->fx = 0;
+    ball->fy = 0;
 }
 
-// Start ball movement after delay
-static void start_ball_after_delay(Ball* ball) { // Restrict scope to this file
-    for (volatile int i = 0; i < 2000000; i++); // Approx. 2-second delay
-    ball->dx = 1; // Start moving horizontally
-    ball->dy = -1; // Start moving upwards
-    ball_is_reset = false;
+// Scale one component of a bounce direction by the ball speed
+static int8_t bounce_velocity(int8_t dir) {
+    return (int8_t)((int16_t)dir * ball_speed / BOUNCE_ONE);
 }
 
-// Update ball position
-void ball_update(Ball* ball, Paddle* paddle) {
-    const int y_offset = 10; // Offset for the top edge collision
+// Point the ball along a bounce direction
+void ball_aim(Ball* ball, uint8_t angle) {
+    ball->dx = bounce_velocity(bounce_dirs[angle].x);
+    ball->dy = bounce_velocity(bounce_dirs[angle].y);
+}
+
+// Start serving: the ball waits on the paddle from now on
+void ball_serve(uint32_t now) {
+    game_state = GAME_STATE_SERVE;
+    serve_time = now;
+}
+
+// Launch the served ball
+void ball_launch(BallPool* pool) {
+    if (game_state != GAME_STATE_SERVE) return;
+
+    pool->dx[0] = bounce_velocity(bounce_dirs[BOUNCE_SERVE_ANGLE].x);
+    pool->dy[0] = bounce_velocity(bounce_dirs[BOUNCE_SERVE_ANGLE].y);
+    game_state = GAME_STATE_PLAY;
+}
+
+// Sweep along one axis against the open interval (lo, hi); returns entry/exit times in Q8
+static inline int sweep_axis(int32_t pos, int8_t d, int32_t lo, int32_t hi, int32_t* t_in, int32_t* t_out) {
+    if (d == 0) {
+        if (pos <= lo || pos >= hi) {
+            return 0; // Never overlaps on this axis
+        }
+        *t_in = -0x7FFFFFFF;
+        *t_out = 0x7FFFFFFF;
+    } else if (d > 0) {
+        *t_in = (lo - pos) * BALL_VEL_ONE / d;
+        *t_out = (hi - pos) * BALL_VEL_ONE / d;
+    } else {
+        *t_in = (hi - pos) * BALL_VEL_ONE / d;
+        *t_out = (lo - pos) * BALL_VEL_ONE / d;
+    }
+    return 1;
+}
+
+// Entry and exit times of the ball against a box, Q8
+typedef struct {
+    int32_t tx_in, ty_in;   // Entry time on each axis
+    int32_t t_in, t_out;    // Overlap of both axes
+} SweepSpan;
+
+// Find when the ball overlaps a box given in whole pixels; 0 if it does not within limit
+static int sweep_span(const BallMotion* m, int bx, int by, int bw, int bh, uint16_t limit, SweepSpan* s) {
+    int32_t tx_out, ty_out;
+
+    // Minkowski sum: box grown by the ball size, ball treated as a point
+    if (!sweep_axis(m->x, m->dx, (int32_t)(bx - BALL_SIZE) << 8, (int32_t)(bx + bw) << 8, &s->tx_in, &tx_out) ||
+        !sweep_axis(m->y, m->dy, (int32_t)(by - BALL_SIZE) << 8, (int32_t)(by + bh) << 8, &s->ty_in, &ty_out)) {
+        return 0;
+    }
+
+    s->t_in = (s->tx_in > s->ty_in) ? s->tx_in : s->ty_in;
+    s->t_out = (tx_out < ty_out) ? tx_out : ty_out;
+    return s->t_in < s->t_out && s->t_out > 0 && s->t_in < limit;
+}
+
+// Contact of the ball with a box given in whole pixels, from its sweep span (see sweep_span())
+static int box_contact(const BallMotion* m, int bx, int by, int bw, int bh, const SweepSpan* s, Contact* c) {
+    c->sx = 0;
+    c->sy = 0;
+    if (s->t_in < 0) {
+        // Already overlapping: push out through the nearest face (the center offset
+        // would pick the wrong axis for the thin runs of a collision mask)
+        int32_t left = m->x + (BALL_SIZE << 8) - ((int32_t)bx << 8);
+        int32_t right = ((int32_t)(bx + bw) << 8) - m->x;
+        int32_t up = m->y + (BALL_SIZE << 8) - ((int32_t)by << 8);
+        int32_t down = ((int32_t)(by + bh) << 8) - m->y;
+        int32_t depth_x = (left < right) ? left : right;
+        int32_t depth_y = (up < down) ? up : down;
+        c->time = 0;
+        if (depth_x < depth_y) {
+            c->sx = (left < right) ? -1 : 1;
+        } else {
+            c->sy = (up < down) ? -1 : 1;
+        }
+        if (c->sx * m->dx > 0 || c->sy * m->dy > 0) {
+            return 0; // Already moving out, let it leave
+        }
+        return 1;
+    }
+
+    c->time = (uint16_t)s->t_in;
+    if (s->tx_in >= s->ty_in) {
+        c->sx = (m->dx > 0) ? -1 : 1; // Vertical face (both on an exact corner)
+    }
+    if (s->ty_in >= s->tx_in) {
+        c->sy = (m->dy > 0) ? -1 : 1; // Horizontal face
+    }
+    return 1;
+}
+
+// Swept AABB test of the ball against a box given in whole pixels
+static int sweep_box(const BallMotion* m, int bx, int by, int bw, int bh, uint16_t limit, Contact* c) {
+    SweepSpan s;
+
+    if (!sweep_span(m, bx, by, bw, bh, limit, &s)) {
+        return 0;
+    }
+    return box_contact(m, bx, by, bw, bh, &s, c);
+}
+
+// Block columns and rows the ball covers within limit, from the end points of its motion; returns the
+// rows as a mask when a lit pixel is among them (0 if none), with the column range in *col0 and *col1
+static uint8_t mask_reach(const uint8_t* mask, const BallMotion* m, uint16_t limit, int bx, int by, int* col0, int* col1) {
+    int32_t xa = m->x;
+    int32_t xb = m->x + (int32_t)m->dx * limit / BALL_VEL_ONE;
+    int32_t ya = m->y;
+    int32_t yb = m->y + (int32_t)m->dy * limit / BALL_VEL_ONE;
+    int row0 = (int)(((ya < yb) ? ya : yb) >> 8) - by;
+    int row1 = (int)(((ya > yb) ? ya : yb) >> 8) + BALL_SIZE - by;
+    uint8_t lit = 0;
+
+    *col0 = (int)(((xa < xb) ? xa : xb) >> 8) - bx;
+    *col1 = (int)(((xa > xb) ? xa : xb) >> 8) + BALL_SIZE - bx;
+    if (*col0 < 0) *col0 = 0;
+    if (*col1 >= BLOCK_WIDTH) *col1 = BLOCK_WIDTH - 1;
+    if (row0 < 0) row0 = 0;
+    if (row1 >= BLOCK_HEIGHT) row1 = BLOCK_HEIGHT - 1;
+    if (row0 > row1) {
+        return 0;
+    }
+
+    uint8_t reach = (uint8_t)((2u << row1) - (1u << row0));
+    for (int col = *col0; col <= *col1; col++) {
+        lit |= mask[col];
+    }
+    return (lit & reach) ? reach : 0;
+}
+
+// Time the ball crosses a horizontal pixel line given in Q8. Clamped to 16 bits for the cache in
+// sweep_mask(): times that far out only ever compare as before the tick or after it.
+static int16_t line_time(const BallMotion* m, int32_t line) {
+    int32_t t = (line - m->y) * BALL_VEL_ONE / m->dy;
+    return (int16_t)((t < -0x7FFF) ? -0x7FFF : (t > 0x7FFF) ? 0x7FFF : t);
+}
+
+// Narrow phase against a block's collision mask: each vertical run of lit pixels within reach is swept as a box.
+// Divisions are software on the Cortex-M0+, so a ball that cannot reach a lit pixel is rejected without one,
+// and the others divide once per column and once per pixel row line, not four times per run. The reach is
+// taken over the whole motion rather than the time inside the box: times are truncated, so the box's window
+// can end just short of a corner the ball still clips.
+static int sweep_mask(const BallMotion* m, const uint8_t* mask, int bx, int by, uint16_t limit, Contact* c) {
+    SweepSpan s;
+    Contact hit;
+    int col0, col1;
+    int16_t line_times[BLOCK_HEIGHT + BALL_SIZE + 1]; // Crossing time of row line by - BALL_SIZE + i, once known
+    uint16_t known = 0;
+
+    uint8_t reach = mask_reach(mask, m, limit, bx, by, &col0, &col1);
+    if (!reach) {
+        return 0;
+    }
+
+    // Broadphase: the block's box
+    if (!sweep_span(m, bx, by, BLOCK_WIDTH, BLOCK_HEIGHT, limit, &s)) {
+        return 0;
+    }
+
+    // Already on lit pixels (a map loaded or a row scrolled into play under the ball):
+    // push out of the whole block, single runs would push it different ways
+    if (s.t_in < 0) {
+        int left = (int)(m->x >> 8) - bx;
+        int right = (int)((m->x + (BALL_SIZE << 8) - 1) >> 8) - bx;
+        int top = (int)(m->y >> 8) - by;
+        int bottom = (int)((m->y + (BALL_SIZE << 8) - 1) >> 8) - by;
+        if (left < 0) left = 0;
+        if (right >= BLOCK_WIDTH) right = BLOCK_WIDTH - 1;
+        if (top < 0) top = 0;
+        if (bottom >= BLOCK_HEIGHT) bottom = BLOCK_HEIGHT - 1;
+        uint8_t covered = (uint8_t)((2u << bottom) - (1u << top));
+        for (int col = left; col <= right; col++) {
+            if (mask[col] & covered) {
+                return box_contact(m, bx, by, BLOCK_WIDTH, BLOCK_HEIGHT, &s, c);
+            }
+        }
+    }
+
+    c->time = SWEEP_NO_HIT;
+    for (int col = col0; col <= col1; col++) {
+        uint8_t lit = mask[col];
+        int32_t tx_out;
+        if (!(lit & reach) ||
+            !sweep_axis(m->x, m->dx, (int32_t)(bx + col - BALL_SIZE) << 8, (int32_t)(bx + col + 1) << 8, &s.tx_in, &tx_out)) {
+            continue; // Transparent within reach, or never level with the column
+        }
+
+        // Runs of lit pixels from their lowest bits: top row, then the row past the run
+        for (uint8_t starts = (uint8_t)(lit & ~(lit << 1)); starts; starts &= (uint8_t)(starts - 1)) {
+            int top = __builtin_ctz(starts);
+            int row = top + __builtin_ctz(~((uint32_t)lit >> top));
+            uint8_t run = (uint8_t)((1u << row) - (1u << top));
+            if (!(run & reach)) {
+                continue;
+            }
+
+            // Sweep span of the run's box, as sweep_span() with the row line times divided out once
+            int32_t ty_out;
+            if (m->dy == 0) {
+                if (m->y <= ((int32_t)(by + top - BALL_SIZE) << 8) || m->y >= ((int32_t)(by + row) << 8)) {
+                    continue;
+                }
+                s.ty_in = -0x7FFFFFFF;
+                ty_out = 0x7FFFFFFF;
+            } else {
+                int bottom = row + BALL_SIZE; // The box grown by the ball spans lines top to bottom
+                if (!(known & (1u << top))) {
+                    line_times[top] = line_time(m, (int32_t)(by + top - BALL_SIZE) << 8);
+                }
+                if (!(known & (1u << bottom))) {
+                    line_times[bottom] = line_time(m, (int32_t)(by + bottom - BALL_SIZE) << 8);
+                }
+                known |= (uint16_t)((1u << top) | (1u << bottom));
+                s.ty_in = (m->dy > 0) ? line_times[top] : line_times[bottom];
+                ty_out = (m->dy > 0) ? line_times[bottom] : line_times[top];
+            }
+            s.t_in = (s.tx_in > s.ty_in) ? s.tx_in : s.ty_in;
+            s.t_out = (tx_out < ty_out) ? tx_out : ty_out;
+            if (!(s.t_in < s.t_out && s.t_out > 0 && s.t_in < limit) ||
+                !box_contact(m, bx + col, by + top, 1, row - top, &s, &hit)) {
+                continue;
+            }
+
+            // A side shared with a lit neighbour column is inside the sprite, not a face
+            int side = col + hit.sx;
+            if (hit.sx != 0 && side >= 0 && side < BLOCK_WIDTH && (mask[side] & run) == run) {
+                hit.sx = 0;
+            }
+            if ((hit.sx == 0 && hit.sy == 0) || hit.time > c->time) {
+                continue;
+            }
+            if (hit.time < c->time) {
+                *c = hit;
+            } else {
+                if (c->sx == 0) c->sx = hit.sx;
+                if (c->sy == 0) c->sy = hit.sy;
+            }
+        }
+    }
+    return c->time != SWEEP_NO_HIT;
+}
+
+// Swept test against a wall plane; returns time of impact, or SWEEP_NO_HIT when the
+// wall is too far to reach in the range of the time type (slow balls, far walls)
+static uint16_t sweep_wall(int32_t pos, int8_t d, int32_t wall) {
+    int32_t t = (wall - pos) * BALL_VEL_ONE / d;
+    if (t >= SWEEP_NO_HIT) {
+        return SWEEP_NO_HIT;
+    }
+    return (uint16_t)((t < 0) ? 0 : t);
+}
+
+// Contacts gathered for the earliest time of impact in the current sweep
+typedef struct {
+    Contact first;                      // Earliest contact with merged bounce directions
+    uint8_t paddle;                     // Paddle is part of the earliest contact
+    uint8_t num_blocks;                 // Number of blocks touched at that time
+    uint8_t block[SWEEP_MAX_CONTACTS];  // Indices of those blocks
+} SweepResult;
+
+#define CONTACT_WALL   -1
+#define CONTACT_PADDLE -2
 
-    // If ball is reset, wait and start movement after delay
-    if (ball_is_reset) {
-        reset_ball(ball, paddle);
-        start_ball_after_delay(ball);
+// Keep only the earliest contacts; simultaneous ones are merged so the ball flips once
+static void record_contact(SweepResult* r, const Contact* c, int index) {
+    if (c->time > r->first.time) {
         return;
     }
+    if (c->time < r->first.time) {
+        r->first = *c;
+        r->paddle = 0;
+        r->num_blocks = 0;
+    } else {
+        if (r->first.sx == 0) r->first.sx = c->sx;
+        if (r->first.sy == 0) r->first.sy = c->sy;
+    }
+
+    if (index == CONTACT_PADDLE) {
+        r->paddle = 1;
+    } else if (index >= 0 && r->num_blocks < SWEEP_MAX_CONTACTS) {
+        r->block[r->num_blocks++] = (uint8_t)index;
+    }
+}
+
+// Grid broadphase: test only the block cells covered by the ball's swept box
+static void sweep_blocks(const BallMotion* m, uint16_t limit, SweepResult* r) {
+    Contact c;
+    int32_t x_end = m->x + (int32_t)m->dx * limit / BALL_VEL_ONE;
+    int32_t y_end = m->y + (int32_t)m->dy * limit / BALL_VEL_ONE;
 
-    ball->x += ball->dx;
-    ball->y += ball->dy;
+    // Pixel extent of the ball over the whole window
+    int x0 = (int)(((m->x < x_end) ? m->x : x_end) >> 8);
+    int x1 = (int)(((m->x > x_end) ? m->x : x_end) >> 8) + BALL_SIZE;
+    int y0 = (int)(((m->y < y_end) ? m->y : y_end) >> 8);
+    int y1 = (int)(((m->y > y_end) ? m->y : y_end) >> 8) + BALL_SIZE;
 
-    // Handle collisions with screen edges
-    if (ball->x <= 0 || ball->x + BALL_SIZE >= SCREEN_WIDTH) {
-        ball->dx = -ball->dx;
+    // Early out when the ball is nowhere near the blocks: above the playfield or
+    // below the lowest row that still has one
+    int last_row = MAP_HEIGHT - 1;
+    while (last_row >= 0 && block_rows[last_row] == 0) {
+        last_row--;
     }
-    if (ball->y <= y_offset) { // Use offset for the top edge
-        ball->dy = -ball->dy;
+    if (last_row < 0 || y1 < view_top + PLAYFIELD_TOP || y0 >= BLOCK_Y(last_row) + BLOCK_HEIGHT) {
+        return;
     }
 
-    // Handle collision with paddle
-    if (ball->y + BALL_SIZE >= paddle->y - 1 && // 1px above paddle
-        ball->x + BALL_SIZE >= paddle->x &&
-        ball->x <= paddle->x + PADDLE_WIDTH) {
-        ball->dy = -ball->dy; // Reverse vertical direction
+    int col0 = (x0 > 0) ? x0 / BLOCK_PITCH_X : 0;
+    int col1 = x1 / BLOCK_PITCH_X;
+    int row0 = (y0 > PLAYFIELD_TOP) ? (y0 - PLAYFIELD_TOP) / BLOCK_PITCH_Y : 0;
+    int row1 = (y1 - PLAYFIELD_TOP) / BLOCK_PITCH_Y;
+    if (col1 >= MAP_WIDTH) col1 = MAP_WIDTH - 1;
+    if (row1 > last_row) row1 = last_row;
+    if (row0 < view_first_row) row0 = view_first_row; // Rows under the HUD are out of play
 
-        // Adjust ball direction based on collision point
-        int relative_x = (ball->x + BALL_SIZE / 2) - paddle->x;
-        if (relative_x < PADDLE_WIDTH / 3) {
-            ball->dx = -2; // Left side of paddle
-        } else if (relative_x > 2 * PADDLE_WIDTH / 3) {
-            ball->dx = 2; // Right side of paddle
-        } else {
-            ball->dx = 1; // Middle of paddle
+    // Active blocks among the covered columns
+    uint16_t cols = (uint16_t)((BLOCK_ROW_BIT(col1) << 1) - BLOCK_ROW_BIT(col0));
+
+    for (int row = row0; row <= row1; row++) {
+        for (uint16_t bits = block_rows[row] & cols; bits; bits &= bits - 1) {
+            uint8_t col = BLOCK_ROW_FIRST(bits);
+            if (check_collision(m, (uint8_t)row, col, limit, &c)) {
+                record_contact(r, &c, BLOCK_INDEX(row, col));
+            }
         }
     }
+}
 
-    // Handle collisions with blocks
-    for (int i = 0; i < NUM_BLOCKS; i++) {
-        if (blocks[i].is_active && check_collision(ball, &blocks[i])) {
-            handle_block_collision(ball, &blocks[i]);
+// Find the earliest contact of the ball with walls, paddle and blocks within limit
+static void sweep_scene(const BallMotion* m, const Paddle* paddle, uint16_t limit, SweepResult* r) {
+    Contact c;
+
+    r->first.time = SWEEP_NO_HIT;
+    r->first.sx = 0;
+    r->first.sy = 0;
+    r->paddle = 0;
+    r->num_blocks = 0;
+
+    // Screen edges
+    c.sy = 0;
+    if (m->dx < 0 && (c.time = sweep_wall(m->x, m->dx, 0)) < limit) {
+        c.sx = 1;
+        record_contact(r, &c, CONTACT_WALL);
+    } else if (m->dx > 0 && (c.time = sweep_wall(m->x, m->dx, (int32_t)(SCREEN_WIDTH - BALL_SIZE) << 8)) < limit) {
+        c.sx = -1;
+        record_contact(r, &c, CONTACT_WALL);
+    }
+    c.sx = 0;
+    if (m->dy < 0 && (c.time = sweep_wall(m->y, m->dy, (int32_t)(view_top + PLAYFIELD_TOP) << 8)) < limit) {
+        c.sy = 1;
+        record_contact(r, &c, CONTACT_WALL);
+    }
+
+    // Paddle (collision starts 1px above it)
+    if (sweep_box(m, paddle->x, paddle->y - 1, paddle->width, PADDLE_HEIGHT + 1, limit, &c)) {
+        if (c.time == 0 && c.sx != 0) {
+            // The paddle slid into the ball: lift it out over the top, pushing it
+            // sideways could wedge it against a wall. A ball already going up is let go.
+            c.sx = 0;
+            c.sy = (m->dy < 0) ? 0 : -1;
+        }
+        if (c.sx != 0 || c.sy != 0) {
+            record_contact(r, &c, CONTACT_PADDLE);
         }
     }
 
-    // If the ball falls below the screen, reset it on the paddle
-    if (ball->y > SCREEN_HEIGHT) {
-        lives--;
-        if (lives > 0) {
-            reset_ball(ball, paddle); // Reset ball on paddle
+    sweep_blocks(m, limit, r);
+}
+
+// Update ball position
+int ball_update(Ball* ball, Paddle* paddle) {
+    BallMotion m = { ((int32_t)ball->x << 8) | ball->fx, ((int32_t)ball->y << 8) | ball->fy, ball->dx, ball->dy };
+    uint16_t remaining = SWEEP_ONE;
+    SweepResult r;
+
+    // Resolve contacts in time order, continuing with the remaining motion after each
+    for (int n = 0; n < SWEEP_MAX_CONTACTS && remaining > 0; n++) {
+        sweep_scene(&m, paddle, remaining, &r);
+        if (r.first.time == SWEEP_NO_HIT) {
+            break;
+        }
+
+        m.x += (int32_t)m.dx * r.first.time / BALL_VEL_ONE;
+        m.y += (int32_t)m.dy * r.first.time / BALL_VEL_ONE;
+        remaining -= r.first.time;
+
+        if (r.first.sx != 0) m.dx = (int8_t)(r.first.sx * abs(m.dx));
+        if (r.first.sy != 0) m.dy = (int8_t)(r.first.sy * abs(m.dy));
+
+        if (r.paddle && r.first.sy < 0) {
+            // The paddle zone that was hit picks the bounce direction
+            int relative_x = (int)(m.x >> 8) + BALL_SIZE / 2 - paddle->x;
+            int zone = relative_x * BOUNCE_ANGLES / paddle->width;
+            if (zone < 0) zone = 0;
+            if (zone >= BOUNCE_ANGLES) zone = BOUNCE_ANGLES - 1;
+            m.dx = bounce_velocity(bounce_dirs[zone].x);
+            m.dy = bounce_velocity(bounce_dirs[zone].y);
+        }
+
+        for (uint8_t i = 0; i < r.num_blocks; i++) {
+            handle_block_collision(r.block[i]);
+        }
+
+        if (n == SWEEP_MAX_CONTACTS - 1) {
+            remaining = 0; // Out of contacts for this tick, drop the rest of the motion
+        }
+    }
+
+    m.x += (int32_t)m.dx * remaining / BALL_VEL_ONE;
+    m.y += (int32_t)m.dy * remaining / BALL_VEL_ONE;
+
+    ball->x = (uint8_t)(m.x >> 8);
+    ball->y = (uint8_t)(m.y >> 8);
+    ball->fx = (uint8_t)m.x;
+    ball->fy = (uint8_t)m.y;
+    ball->dx = m.dx;
+    ball->dy = m.dy;
+
+    return ball->y <= view_top + SCREEN_HEIGHT; // Below the screen the ball is lost
+}
+
+// Copy a ball out of the pool
+static void ball_pool_get(const BallPool* pool, uint8_t i, Ball* ball) {
+    ball->x = pool->x[i];
+    ball->y = pool->y[i];
+    ball->dx = pool->dx[i];
+    ball->dy = pool->dy[i];
+    ball->fx = pool->fx[i];
+    ball->fy = pool->fy[i];
+}
+
+// Store a ball into a pool slot
+static void ball_pool_set(BallPool* pool, uint8_t i, const Ball* ball) {
+    pool->x[i] = ball->x;
+    pool->y[i] = ball->y;
+    pool->dx[i] = ball->dx;
+    pool->dy[i] = ball->dy;
+    pool->fx[i] = ball->fx;
+    pool->fy[i] = ball->fy;
+}
+
+// Start the pool with a single ball
+void ball_pool_init(BallPool* pool, const Ball* ball) {
+    pool->active = 0;
+    ball_pool_spawn(pool, ball);
+}
+
+// Put a ball into the first free slot
+int ball_pool_spawn(BallPool* pool, const Ball* ball) {
+    for (uint8_t i = 0; i < MAX_BALLS; i++) {
+        if (!(pool->active & BALL_BIT(i))) {
+            ball_pool_set(pool, i, ball);
+            pool->active |= BALL_BIT(i);
+            return i;
         }
     }
+    return -1; // Pool full
 }
 
-// Advanced collision check
-int check_collision(Ball* ball, Block* block) {
-    if (ball->x < block->x + BLOCK_WIDTH &&
-        ball->x + BALL_SIZE > block->x &&
-        ball->y < block->y + BLOCK_HEIGHT &&
-        ball->y + BALL_SIZE > block->y) {
-        // Determine collision side
-        int ball_center_x = ball->x + BALL_SIZE / 2;
-        int ball_center_y = ball->y + BALL_SIZE / 2;
+// Advance all balls in play; a life is lost only when the last one drains
+void ball_pool_update(BallPool* pool, Paddle* paddle, uint32_t now) {
+    Ball ball;
 
-        int block_center_x = block->x + BLOCK_WIDTH / 2;
-        int block_center_y = block->y + BLOCK_HEIGHT / 2;
+    // While serving, the ball rides on the paddle until the delay runs out
+    if (game_state == GAME_STATE_SERVE) {
+        reset_ball(&ball, paddle);
+        ball_pool_init(pool, &ball);
+        if ((uint32_t)(now - serve_time) >= SERVE_DELAY_MS) {
+            ball_launch(pool);
+        }
+        return;
+    }
 
-        int dx = ball_center_x - block_center_x;
-        int dy = ball_center_y - block_center_y;
+    for (uint16_t bits = pool->active; bits; bits &= bits - 1) {
+        uint8_t i = (uint8_t)__builtin_ctz(bits);
 
-        if (abs(dx) > abs(dy)) {
-            ball->dx = (dx > 0) ? 1 : -1; // Horizontal collision
+        ball_pool_get(pool, i, &ball);
+        if (ball_update(&ball, paddle)) {
+            ball_pool_set(pool, i, &ball);
         } else {
-            ball->dy = (dy > 0) ? 1 : -1; // Vertical collision
+            pool->active &= (uint16_t)~BALL_BIT(i); // Drained
         }
+    }
 
-        return 1;
+    if (pool->active == 0) {
+        lives--;
+        event_post(EVENT_LIFE_LOST, (uint8_t)lives);
+        if (lives > 0) {
+            reset_ball(&ball, paddle); // Reset ball on paddle
+            ball_pool_init(pool, &ball);
+            ball_serve(now);
+        }
     }
-    return 0;
+}
+
+// Swept collision check against a single block
+int check_collision(const BallMotion* motion, uint8_t row, uint8_t col, uint16_t limit, Contact* contact) {
+    uint8_t type = block_get_type(BLOCK_INDEX(row, col));
+
+    if (type >= BLOCK_TYPE_COUNT || (block_masks_solid & (1u << type))) {
+        return sweep_box(motion, BLOCK_X(col), BLOCK_Y(row), BLOCK_WIDTH, BLOCK_HEIGHT, limit, contact);
+    }
+    return sweep_mask(motion, block_masks[type], BLOCK_X(col), BLOCK_Y(row), limit, contact);
 }
 
 // Handle block collision
-void handle_block_collision(Ball* ball, Block* block) {
-    block->is_active = 0; // Deactivate block
+void handle_block_collision(uint8_t index) {
+    BlockType type = (BlockType)block_get_type(index);
+    uint8_t hits = type_hits(type);
+
+    if (hits == BLOCK_INDESTRUCTIBLE) {
+        return; // The ball only bounces off
+    }
+
+    // Damage nibbles share the layout of the type nibbles
+    uint8_t damage = (uint8_t)(cell_type(block_damage, index) + 1);
+    if (damage < hits) {
+        cell_set_type(block_damage, index, damage);
+        return;
+    }
+    cell_set_type(block_damage, index, 0);
+
+    block_set_type(index, 0); // Deactivate block
+    block_rows[index / MAP_WIDTH] &= (uint16_t)~BLOCK_ROW_BIT(index % MAP_WIDTH);
+    blocks_remaining--;
+    event_post(EVENT_BLOCK_DESTROYED, index);
 
     // Add points based on block type
-    switch (block->type) {
-        case BLOCK_TYPE_1: current_score += SCORE_BLOCK_TYPE_1; break;
-        case BLOCK_TYPE_2: current_score += SCORE_BLOCK_TYPE_2; break;
-        case BLOCK_TYPE_3: current_score += SCORE_BLOCK_TYPE_3; break;
-        case BLOCK_TYPE_4: current_score += SCORE_BLOCK_TYPE_4; break;
-        default: current_score += 10; break;
+    uint8_t points;
+    switch (type) {
+        case BLOCK_TYPE_1: points = SCORE_BLOCK_TYPE_1; break;
+        case BLOCK_TYPE_2: points = SCORE_BLOCK_TYPE_2; break;
+        case BLOCK_TYPE_3: points = SCORE_BLOCK_TYPE_3; break;
+        case BLOCK_TYPE_4: points = SCORE_BLOCK_TYPE_4; break;
+        case BLOCK_TYPE_WOOD: points = SCORE_BLOCK_WOOD; break;
+        case BLOCK_TYPE_STONE: points = SCORE_BLOCK_STONE; break;
+        default: points = 10; break;
+    }
+    current_score += points;
+    event_post(EVENT_SCORE_CHANGED, points);
+
+    if (blocks_remaining == 0) {
+        event_post(EVENT_MAP_CLEARED, (uint8_t)current_map);
+    }
+}
+
+#ifdef ARKANOID_HOST
+// Debug check: row bitmasks and counter must match the packed cells
+static void check_block_rows(void) {
+    int count = 0;
+    for (int i = 0; i < NUM_BLOCKS; i++) {
+        int bit = (block_rows[i / MAP_WIDTH] & BLOCK_ROW_BIT(i % MAP_WIDTH)) != 0;
+        assert(bit == (block_get_type((uint8_t)i) != 0));
+        assert(cell_type(block_damage, (uint8_t)i) == 0 || cell_type(block_damage, (uint8_t)i) < type_hits(block_get_type((uint8_t)i)));
+        count += bit && type_hits(block_get_type((uint8_t)i)) != BLOCK_INDESTRUCTIBLE;
     }
+    assert(count == blocks_remaining);
 }
+#endif
 
 // Check if all blocks are destroyed
 int check_map_complete(void) {
-    for (int i = 0; i < NUM_BLOCKS; i++) {
-        if (blocks[i].is_active) {
-            return 0;
+#ifdef ARKANOID_HOST
+    check_block_rows();
+#endif
+    return blocks_remaining == 0;
+}
+
+// View top that puts the lowest row with a destructible block just above VIEW_BLOCKS_BOTTOM
+static uint8_t view_target(void) {
+    for (int8_t row = MAP_HEIGHT - 1; row >= 0; row--) {
+        // Indestructible blocks do not hold the view: the rows above them must come into play
+        for (uint16_t bits = block_rows[row]; bits; bits &= bits - 1) {
+            if (type_hits(block_get_type(BLOCK_INDEX(row, BLOCK_ROW_FIRST(bits)))) != BLOCK_INDESTRUCTIBLE) {
+                uint8_t bottom = BLOCK_Y(row) + BLOCK_HEIGHT;
+                return (bottom > VIEW_BLOCKS_BOTTOM) ? (uint8_t)(bottom - VIEW_BLOCKS_BOTTOM) : 0;
+            }
         }
     }
-    return 1;
+    return 0;
+}
+
+// Place the view and work out which block rows it leaves in play
+void view_set(uint8_t top) {
+    view_top = top;
+    view_first_row = (uint8_t)((top + BLOCK_PITCH_Y - 1) / BLOCK_PITCH_Y);
+}
+
+// Follow the blocks: scroll up as rows clear, jump down for a taller map
+void view_update(Paddle* paddle, BallPool* balls) {
+    uint8_t target = view_target();
+
+    if (target > view_top) {
+        uint8_t shift = target - view_top;
+        for (uint16_t bits = balls->active; bits; bits &= bits - 1) {
+            balls->y[__builtin_ctz(bits)] += shift; // Keep their place on screen
+        }
+        view_set(target);
+    } else if (target < view_top) {
+        view_set(view_top - 1);
+    }
+    paddle->y = view_top + PADDLE_VIEW_Y;
 }
 
 // Update paddle position
 void paddle_update(Paddle* paddle, uint8_t touch_pos) {
-    paddle->x = touch_pos * (SCREEN_WIDTH - PADDLE_WIDTH) / 100;
+    uint8_t x = (uint8_t)(touch_pos * (SCREEN_WIDTH - paddle->width) / 100);
+
+    if (x != paddle->x) {
+        paddle->x = x;
+        event_post(EVENT_PADDLE_MOVED, x);
+    }
 }
 
 // Get current lives
@@ -183,5 +837,44 @@ void game_init(void) {
     current_score = 0;
     current_map = 0;
     lives = MAX_LIVES;
+    game_state = GAME_STATE_PLAY;
+    ball_speed = BALL_SPEED_DEFAULT;
+    view_set(0);
+    powerup_init();
     load_next_map();
 }
+
+#ifdef ARKANOID_HOST
+// Save the state of the current game
+void game_context_save(GameContext* context) {
+    memcpy(context->cells, live_map->cells, BLOCK_CELLS_SIZE);
+    memcpy(context->rows, live_map->rows, sizeof(context->rows));
+    memcpy(context->damage, block_damage, BLOCK_CELLS_SIZE);
+    context->remaining = blocks_remaining;
+    context->score = current_score;
+    context->map = current_map;
+    context->lives = lives;
+    context->state = game_state;
+    context->seed = game_seed;
+    context->serve_time = serve_time;
+    context->ball_speed = ball_speed;
+    context->view_top = view_top;
+}
+
+// Switch to a saved game
+void game_context_load(const GameContext* context) {
+    memcpy(live_map->cells, context->cells, BLOCK_CELLS_SIZE);
+    memcpy(live_map->rows, context->rows, sizeof(context->rows));
+    memcpy(block_damage, context->damage, BLOCK_CELLS_SIZE);
+    blocks_remaining = context->remaining;
+    current_score = context->score;
+    current_map = context->map;
+    lives = context->lives;
+    game_state = context->state;
+    game_seed = context->seed;
+    serve_time = context->serve_time;
+    ball_speed = context->ball_speed;
+    view_set(context->view_top);
+    staged_map = -1; // Staged for another game, maybe with another seed
+}
+#endif
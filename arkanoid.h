@@ -2,29 +2,31 @@
 #define ARKANOID_H
 
 #include <stdint.h>
+#include "maps.h"
 
 /** 
  * @brief Screen and game element parameters.
  */
 #define SCREEN_WIDTH 128        ///< Screen width in pixels.
 #define SCREEN_HEIGHT 64        ///< Screen height in pixels.
-#define PADDLE_WIDTH 20         ///< Paddle width in pixels.
+#define PADDLE_WIDTH 20         ///< Default paddle width in pixels.
 #define PADDLE_HEIGHT 5         ///< Paddle height in pixels.
 #define BALL_SIZE 2             ///< Ball size in pixels.
 #define BLOCK_WIDTH 12          ///< Block width in pixels.
 #define BLOCK_HEIGHT 6          ///< Block height in pixels.
 #define MAX_LIVES 3             ///< Maximum number of lives.
-#define NUM_BLOCKS (MAP_WIDTH * MAP_HEIGHT) ///< Total number of blocks on the screen.
-
-/** 
- * @brief Map parameters.
- */
-#define NUM_MAPS 25             ///< Number of available maps.
-#define MAP_WIDTH 10            ///< Width of the map in blocks.
-#define MAP_HEIGHT 4            ///< Height of the map in blocks.
+#define PLAYFIELD_TOP 10        ///< Top wall of the playfield (below the HUD) in pixels from the top of the view.
+#define PADDLE_VIEW_Y (SCREEN_HEIGHT - PADDLE_HEIGHT - 5) ///< Paddle y in pixels from the top of the view.
+#define VIEW_BLOCKS_BOTTOM (PLAYFIELD_TOP + 4 * BLOCK_PITCH_Y - 1) ///< The view scrolls so the lowest blocks end above this row.
+#define NUM_BLOCKS (MAP_WIDTH * MAP_HEIGHT) ///< Number of cells in the block field (map capacity).
+#define BLOCK_PITCH_X (BLOCK_WIDTH + 1)  ///< Horizontal grid step between blocks in pixels.
+#define BLOCK_PITCH_Y (BLOCK_HEIGHT + 1) ///< Vertical grid step between blocks in pixels.
+#define BLOCK_FIELD_BOTTOM (PLAYFIELD_TOP + MAP_HEIGHT * BLOCK_PITCH_Y) ///< First world row below the block grid.
 
 /**
  * @brief Types of blocks in the game.
+ *
+ * The number of hits a block takes is given by block_hits for its type.
  */
 typedef enum {
     BLOCK_TYPE_1,               ///< Type 1 block.
@@ -33,10 +35,11 @@ typedef enum {
     BLOCK_TYPE_4,               ///< Type 4 block.
     BLOCK_TYPE_5,               ///< Type 5 block.
     BLOCK_TYPE_6,               ///< Type 6 block.
-    BLOCK_TYPE_STONE,           ///< Stone block (harder to break).
-    BLOCK_TYPE_STEEL,           ///< Steel block (stronger).
-    BLOCK_TYPE_WOOD,            ///< Wooden block.
-    BLOCK_TYPE_SHADED           ///< Shaded block (visual effect).
+    BLOCK_TYPE_STONE,           ///< Stone block (three hits).
+    BLOCK_TYPE_STEEL,           ///< Steel block (indestructible).
+    BLOCK_TYPE_WOOD,            ///< Wooden block (two hits).
+    BLOCK_TYPE_SHADED,          ///< Shaded block (visual effect).
+    BLOCK_TYPE_COUNT            ///< Number of block types.
 } BlockType;
 
 /**
@@ -44,44 +47,188 @@ typedef enum {
  */
 typedef struct {
     uint8_t x, y;               ///< Current position of the ball.
-    int8_t dx, dy;              ///< Movement direction of the ball.
+    int8_t dx, dy;              ///< Velocity of the ball in 1/BALL_VEL_ONE pixel per tick.
+    uint8_t fx, fy;             ///< Sub-pixel part of the position in 1/256 pixel.
 } Ball;
 
+/**
+ * @brief Ball pool capacity (multiball).
+ */
+#ifndef MAX_BALLS
+#define MAX_BALLS 4             ///< Maximum number of balls in play at once (up to 16).
+#endif
+#define BALL_BIT(i) ((uint16_t)(1u << (i))) ///< Active mask bit of a pool slot.
+
+/**
+ * @brief Pool of balls in play, stored as a structure of arrays.
+ */
+typedef struct {
+    uint8_t x[MAX_BALLS], y[MAX_BALLS];   ///< Positions of the balls.
+    int8_t dx[MAX_BALLS], dy[MAX_BALLS];  ///< Velocities of the balls (see Ball).
+    uint8_t fx[MAX_BALLS], fy[MAX_BALLS]; ///< Sub-pixel parts of the positions.
+    uint16_t active;                      ///< Bit n is set while ball n is in play.
+} BallPool;
+
 /**
  * @brief Structure representing the paddle.
  */
 typedef struct {
     uint8_t x, y;               ///< Current position of the paddle.
+    uint8_t width;              ///< Current width of the paddle in pixels.
 } Paddle;
 
 /**
- * @brief Structure representing a block.
+ * @brief Ball velocity parameters.
+ *
+ * Velocities are fixed point with BALL_VEL_SHIFT fractional bits, so shallow
+ * angles keep their slope instead of rounding to whole pixels per tick.
+ */
+#define BALL_VEL_SHIFT 4                    ///< Fractional bits of a ball velocity.
+#define BALL_VEL_ONE (1 << BALL_VEL_SHIFT)  ///< Velocity of one pixel per tick.
+#define BALL_SPEED_DEFAULT 24               ///< Ball speed at the start of a game (1.5 px per tick).
+
+/**
+ * @brief Paddle bounce directions.
+ *
+ * The paddle is split into BOUNCE_ANGLES zones; the zone the ball hits picks a
+ * unit vector from bounce_dirs (Q7, generated by tools/gen_bounce_table.py)
+ * that is scaled by ball_speed.
+ */
+#define BOUNCE_ANGLES 16        ///< Number of paddle zones / launch directions.
+#define BOUNCE_ONE 128          ///< Length of a unit vector in bounce_dirs.
+#define BOUNCE_SERVE_ANGLE 12   ///< Direction of a served ball (up and to the right).
+
+/**
+ * @brief Unit direction vector in Q7.
  */
 typedef struct {
-    uint8_t x, y;               ///< Position of the block.
-    BlockType type;             ///< Type of the block.
-    uint8_t is_active;          ///< Indicates if the block is active (1) or destroyed (0).
-} Block;
+    int8_t x, y;                ///< Components, BOUNCE_ONE = 1.0.
+} BounceDir;
+
+/**
+ * @brief Ball serve parameters.
+ */
+#define SERVE_DELAY_MS 2000     ///< Time the ball rests on the paddle before it launches by itself.
+
+/**
+ * @brief States of a game in progress.
+ */
+typedef enum {
+    GAME_STATE_PLAY,            ///< Balls are in play.
+    GAME_STATE_SERVE            ///< Ball rests on the paddle and waits to be launched.
+} GameState;
+
+/**
+ * @brief Block grid addressing.
+ *
+ * Blocks are stored as one 4-bit type per map cell (0 = empty); their world
+ * position is a pure function of the cell's row and column. The hits a
+ * multi-hit block has taken are kept in a second nibble array with the same
+ * layout (block_damage).
+ *
+ * All game objects live in world coordinates. A map taller than the screen
+ * is shown through a view whose top is world row view_top; block rows that do
+ * not lie fully below the HUD (before view_first_row) are out of play.
+ */
+#define BLOCK_INDEX(row, col) ((row) * MAP_WIDTH + (col))               ///< Cell index of a map position.
+#define BLOCK_X(col) ((uint8_t)((col) * BLOCK_PITCH_X))                 ///< World x of a block column.
+#define BLOCK_Y(row) ((uint8_t)((row) * BLOCK_PITCH_Y + PLAYFIELD_TOP)) ///< World y of a block row.
+
+/**
+ * @brief Block occupancy bitmask helpers.
+ *
+ * Bit n of a row mask is set while the block in column n of that row is active.
+ */
+#define BLOCK_ROW_BIT(col) ((uint16_t)(1u << (col)))     ///< Mask bit of a map column.
+#define BLOCK_ROW_FIRST(bits) ((uint8_t)__builtin_ctz(bits)) ///< Column of the lowest active block in a non-zero mask.
+#define BLOCK_CELLS_SIZE ((NUM_BLOCKS + 1) / 2)          ///< Bytes of packed cells in a map's block state.
+#define BLOCK_INDESTRUCTIBLE 0                           ///< block_hits entry of a block the ball cannot destroy.
+
+/**
+ * @brief Swept collision parameters.
+ *
+ * Time inside a tick is expressed in Q8 fixed point, so SWEEP_ONE is the
+ * whole tick and positions during the sweep are kept in 1/256 pixel.
+ */
+#define SWEEP_ONE 256           ///< One full tick in Q8 time units.
+#define SWEEP_NO_HIT 0xFFFF     ///< Time value meaning "no contact within the tick".
+#define SWEEP_MAX_CONTACTS 4    ///< Maximum number of contacts resolved in one tick.
+
+/**
+ * @brief Ball motion state used by the swept collision solver.
+ */
+typedef struct {
+    int32_t x, y;               ///< Position of the ball in 1/256 pixel.
+    int8_t dx, dy;              ///< Velocity of the ball in 1/BALL_VEL_ONE pixel per tick.
+} BallMotion;
+
+/**
+ * @brief Earliest contact found along the ball's motion.
+ */
+typedef struct {
+    uint16_t time;              ///< Time of impact in Q8 (0 to SWEEP_ONE).
+    int8_t sx, sy;              ///< Required sign of dx/dy after the contact (0 = unchanged).
+} Contact;
 
 /**
  * @brief Global variables.
  */
-extern Block blocks[NUM_BLOCKS]; ///< Array of blocks for the current map.
+extern uint8_t* block_cells;     ///< Packed block types of the current map, two cells per byte (BLOCK_CELLS_SIZE).
+extern uint16_t* block_rows;     ///< Active block bitmask for each map row (MAP_HEIGHT).
+extern uint8_t block_damage[BLOCK_CELLS_SIZE]; ///< Hits taken by each block of the current map, two cells per byte.
+extern uint8_t blocks_remaining; ///< Number of destructible blocks left on the current map.
 extern int current_score;        ///< Current score of the player.
 extern int current_map;          ///< Index of the current map.
 extern int game_speed;           ///< Current game speed.
 extern int lives;                ///< Number of lives remaining for the player.
+extern GameState game_state;     ///< Current state of the game in progress.
+extern uint32_t game_seed;       ///< Seed of the game's pseudo-random choices (stored in replays).
+extern uint8_t ball_speed;       ///< Length of the ball velocity in 1/BALL_VEL_ONE pixel per tick.
+extern uint8_t view_top;         ///< World row shown at the top of the screen.
+extern uint8_t view_first_row;   ///< First block row in play (fully below the HUD).
+extern const BounceDir bounce_dirs[BOUNCE_ANGLES]; ///< Paddle bounce directions, left edge first.
+extern const uint8_t block_masks[BLOCK_TYPE_COUNT][BLOCK_WIDTH]; ///< Collision masks, one page byte per column.
+extern const uint16_t block_masks_solid; ///< Bit per block type whose mask covers the whole block.
+extern const uint8_t block_hits[BLOCK_TYPE_COUNT]; ///< Hits each block type takes, or BLOCK_INDESTRUCTIBLE.
 
 /**
  * @brief Game functions.
  */
 
 /**
- * @brief Converts a given map array to the block array.
+ * @brief Returns the type stored in a map cell.
+ *
+ * @param index Cell index (see BLOCK_INDEX).
+ * @return Block type of the cell, 0 if the cell is empty.
+ */
+uint8_t block_get_type(uint8_t index);
+
+/**
+ * @brief Stores a block type in a map cell.
+ *
+ * @param index Cell index (see BLOCK_INDEX).
+ * @param type Block type (0 to 15, 0 = empty).
+ */
+void block_set_type(uint8_t index, uint8_t type);
+
+/**
+ * @brief Loads a packed map into the block state.
+ *
+ * Unpacks the record's cells and rebuilds the row bitmasks and block
+ * counter. A sparse record costs time in proportion to its blocks only.
  * 
- * @param map The 2D array representing the map layout.
+ * @param map Packed map record (see maps_data).
+ */
+void convert_map(const uint8_t* map);
+
+/**
+ * @brief Removes every block whose bit is clear in the given row masks.
+ *
+ * Restores a game in progress on top of its freshly loaded map.
+ *
+ * @param rows Active block bitmask for each map row (MAP_HEIGHT entries).
  */
-void convert_map(const int map[MAP_HEIGHT][MAP_WIDTH]);
+void block_keep_rows(const uint16_t* rows);
 
 /**
  * @brief Initializes the game settings.
@@ -95,11 +242,45 @@ void map_init(void);
 
 /**
  * @brief Loads the next map in the sequence.
+ *
+ * The predefined maps come first; later levels are made by mapgen_build()
+ * from game_seed, and after NUM_LEVELS the generated levels start over.
+ * If map_prepare() already decoded that map, the switch is only a swap of
+ * the live and staging block state.
  */
 void load_next_map(void);
 
+/**
+ * @brief Decodes the map that follows the current one into the staging buffer.
+ *
+ * Meant for idle time in the frame loop; returns at once if the next map is
+ * already staged.
+ */
+void map_prepare(void);
+
+/**
+ * @brief Moves the view towards the lowest remaining blocks.
+ *
+ * The view scrolls up one pixel per tick as low rows are cleared and jumps
+ * down at once for a taller map, moving the balls along so they keep their
+ * place on screen. The paddle always stays PADDLE_VIEW_Y below the view top.
+ *
+ * @param paddle Pointer to the paddle structure.
+ * @param balls Pointer to the ball pool.
+ */
+void view_update(Paddle* paddle, BallPool* balls);
+
+/**
+ * @brief Places the view without scrolling.
+ *
+ * @param top World row shown at the top of the screen.
+ */
+void view_set(uint8_t top);
+
 /**
  * @brief Updates the paddle's position based on input.
+ *
+ * Posts EVENT_PADDLE_MOVED when the position changes.
  * 
  * @param paddle Pointer to the paddle structure.
  * @param touch_pos The position from the touch input (0-100 scale).
@@ -111,30 +292,102 @@ void paddle_update(Paddle* paddle, uint8_t touch_pos);
  * 
  * @param ball Pointer to the ball structure.
  * @param paddle Pointer to the paddle structure.
+ * @return 1 while the ball is in play, 0 once it fell below the screen.
  */
-void ball_update(Ball* ball, Paddle* paddle);
+int ball_update(Ball* ball, Paddle* paddle);
 
 /**
- * @brief Checks for a collision between the ball and a block.
- * 
+ * @brief Sets the ball's velocity to a bounce direction at the current ball speed.
+ *
  * @param ball Pointer to the ball structure.
- * @param block Pointer to the block structure.
+ * @param angle Index into bounce_dirs (0 to BOUNCE_ANGLES - 1).
+ */
+void ball_aim(Ball* ball, uint8_t angle);
+
+/**
+ * @brief Empties the ball pool and puts a single ball in it.
+ *
+ * @param pool Pointer to the ball pool.
+ * @param ball Initial state of the first ball.
+ */
+void ball_pool_init(BallPool* pool, const Ball* ball);
+
+/**
+ * @brief Adds a ball to the pool.
+ *
+ * @param pool Pointer to the ball pool.
+ * @param ball Initial state of the new ball.
+ * @return Slot index of the ball, -1 if the pool is full.
+ */
+int ball_pool_spawn(BallPool* pool, const Ball* ball);
+
+/**
+ * @brief Advances every ball in the pool by one tick.
+ *
+ * Each ball is resolved against walls, paddle and blocks. Balls that fall
+ * below the screen leave the pool; a life is lost only when the last one
+ * drains (EVENT_LIFE_LOST), after which the game enters GAME_STATE_SERVE. While serving the
+ * ball follows the paddle and launches once SERVE_DELAY_MS have passed.
+ *
+ * @param pool Pointer to the ball pool.
+ * @param paddle Pointer to the paddle structure.
+ * @param now Current time in milliseconds.
+ */
+void ball_pool_update(BallPool* pool, Paddle* paddle, uint32_t now);
+
+/**
+ * @brief Enters GAME_STATE_SERVE.
+ *
+ * The ball is placed on the paddle by the next ball_pool_update() and
+ * launches SERVE_DELAY_MS after @p now.
+ *
+ * @param now Current time in milliseconds.
+ */
+void ball_serve(uint32_t now);
+
+/**
+ * @brief Launches the served ball without waiting for the serve delay.
+ *
+ * Does nothing unless the game is in GAME_STATE_SERVE.
+ *
+ * @param pool Pointer to the ball pool.
+ */
+void ball_launch(BallPool* pool);
+
+/**
+ * @brief Sweeps the ball against a block and finds the time of impact.
+ *
+ * Only contacts earlier than @p limit are reported. A ball that already
+ * overlaps the block reports a contact at time 0 pushing it out.
+ *
+ * Blocks whose sprite has transparent pixels are tested in two steps: the
+ * block's box first, then the lit pixels of its collision mask (generated
+ * from the sprite by tools/gen_block_masks.py) that the ball can reach.
+ *
+ * @param motion Ball motion state at the start of the sweep.
+ * @param row Map row of the block.
+ * @param col Map column of the block.
+ * @param limit Remaining time of the tick in Q8.
+ * @param contact Filled with the time and bounce direction on a hit.
  * @return 1 if a collision is detected, 0 otherwise.
  */
-int check_collision(Ball* ball, Block* block);
+int check_collision(const BallMotion* motion, uint8_t row, uint8_t col, uint16_t limit, Contact* contact);
 
 /**
  * @brief Handles the collision between the ball and a block.
  * 
- * Updates the block state and adjusts the ball's direction.
+ * Counts the hit against the block's hit points. The hit that uses up the
+ * last one clears the block from the map, adds its score and posts
+ * EVENT_BLOCK_DESTROYED and EVENT_SCORE_CHANGED (plus EVENT_MAP_CLEARED
+ * for the last destructible block). Indestructible blocks only bounce the
+ * ball.
  * 
- * @param ball Pointer to the ball structure.
- * @param block Pointer to the block structure.
+ * @param index Cell index of the block that was hit.
  */
-void handle_block_collision(Ball* ball, Block* block);
+void handle_block_collision(uint8_t index);
 
 /**
- * @brief Resets the ball position to the initial state.
+ * @brief Places a motionless ball on the middle of the paddle.
  * 
  * @param ball Pointer to the ball structure.
  * @param paddle Pointer to the paddle structure.
@@ -148,8 +401,12 @@ void game_speed_update(void);
 
 /**
  * @brief Checks if the current map is complete.
+ *
+ * Compares the live counter of destructible blocks against zero, so
+ * indestructible blocks left on the map do not hold it up. Host builds
+ * (ARKANOID_HOST) also cross-check the row bitmasks against the packed cells.
  * 
- * @return 1 if all blocks are destroyed, 0 otherwise.
+ * @return 1 if all destructible blocks are destroyed, 0 otherwise.
  */
 int check_map_complete(void);
 
@@ -167,4 +424,42 @@ int get_lives(void);
  */
 int get_score(void);
 
+#ifdef ARKANOID_HOST
+/**
+ * @brief Engine state of one game, for host tools that step many games in one process.
+ *
+ * Holds the live map, the counters, the view and the serve timer. The map
+ * staged by map_prepare() and the event queue are not part of it: loading a
+ * context drops the staged map, and the queue must be drained between games.
+ */
+typedef struct {
+    uint8_t cells[BLOCK_CELLS_SIZE];    ///< Packed block types of the live map.
+    uint16_t rows[MAP_HEIGHT];          ///< Active block bitmask for each row.
+    uint8_t damage[BLOCK_CELLS_SIZE];   ///< Hits taken by each block.
+    uint8_t remaining;                  ///< Destructible blocks left.
+    int score;                          ///< Current score.
+    int map;                            ///< Index of the current map.
+    int lives;                          ///< Lives remaining.
+    GameState state;                    ///< State of the game in progress.
+    uint32_t seed;                      ///< Game seed.
+    uint32_t serve_time;                ///< Time the current serve started, in ms.
+    uint8_t ball_speed;                 ///< Ball speed.
+    uint8_t view_top;                   ///< View position.
+} GameContext;
+
+/**
+ * @brief Copies the engine state of the current game into a context.
+ *
+ * @param context Filled with the state.
+ */
+void game_context_save(GameContext* context);
+
+/**
+ * @brief Makes a saved game the current one.
+ *
+ * @param context State saved by game_context_save().
+ */
+void game_context_load(const GameContext* context);
+#endif
+
 #endif // ARKANOID_H
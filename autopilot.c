@@ -0,0 +1,90 @@
+#include "autopilot.h"
+
+#define BALL_X_MAX (SCREEN_WIDTH - BALL_SIZE) // Rightmost x of the ball
+
+static AutopilotConfig config;
+static uint32_t rng_state;
+static int8_t aim_error = 0;       // Aiming error of the current approach
+static uint8_t approaching = 0;    // A ball is moving down towards the paddle
+
+// xorshift32; the state must never be zero
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+void autopilot_init(const AutopilotConfig* cfg, uint32_t seed) {
+    config = *cfg;
+    rng_state = seed ? seed : 0x2545F491u;
+    aim_error = 0;
+    approaching = 0;
+}
+
+// Fold an unbounded x back between the side walls (each wall mirrors the motion)
+static uint8_t reflect_x(int32_t x) {
+    int32_t period = 2 * BALL_X_MAX;
+
+    x %= period;
+    if (x < 0) x += period;
+    if (x > BALL_X_MAX) x = period - x;
+    return (uint8_t)x;
+}
+
+int autopilot_predict(const BallPool* balls, const Paddle* paddle, uint8_t* x) {
+    int32_t line = paddle->y - 1 - BALL_SIZE; // Ball y when it touches the paddle
+    int best = -1;
+
+    for (uint16_t bits = balls->active; bits; bits &= bits - 1) {
+        uint8_t i = (uint8_t)__builtin_ctz(bits);
+        int32_t dy = balls->dy[i];
+
+        if (dy <= 0 || balls->y[i] > line) {
+            continue; // Moving up, waiting on the paddle, or already past it
+        }
+
+        int ticks = (int)(((line - balls->y[i]) * BALL_VEL_ONE + dy - 1) / dy);
+        if (best < 0 || ticks < best) {
+            best = ticks;
+            *x = reflect_x((int32_t)balls->x[i] + (int32_t)balls->dx[i] * ticks / BALL_VEL_ONE);
+        }
+    }
+    return best;
+}
+
+uint8_t autopilot_input(const BallPool* balls, const Paddle* paddle) {
+    uint8_t ball_x;
+    int32_t target;
+    int32_t range = SCREEN_WIDTH - paddle->width;
+
+    if (autopilot_predict(balls, paddle, &ball_x) >= 0) {
+        if (!approaching && config.max_error > 0) {
+            aim_error = (int8_t)((int32_t)(next_random() % (2u * config.max_error + 1)) - config.max_error);
+        }
+        approaching = 1;
+    } else {
+        // Nothing coming down: drift towards the first ball in play, or hold still
+        approaching = 0;
+        if (balls->active == 0) {
+            ball_x = (uint8_t)(paddle->x + paddle->width / 2 - BALL_SIZE / 2);
+        } else {
+            ball_x = balls->x[__builtin_ctz(balls->active)];
+        }
+    }
+
+    // Center the paddle under the ball, off by the aiming error
+    target = (int32_t)ball_x + BALL_SIZE / 2 - paddle->width / 2 + aim_error;
+    if (config.max_step > 0) {
+        if (target > paddle->x + config.max_step) target = paddle->x + config.max_step;
+        if (target < paddle->x - config.max_step) target = paddle->x - config.max_step;
+    }
+    if (target < 0) target = 0;
+    if (target > range) target = range;
+
+    // Invert paddle_update(): x = touch * range / 100, rounded up so the paddle reaches the target
+    int32_t touch = (target * 100 + range - 1) / range;
+    if (touch < 1) touch = 1; // 0 means "slider not touched"
+    if (touch > 100) touch = 100;
+    return (uint8_t)touch;
+}
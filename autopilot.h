@@ -0,0 +1,54 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <stdint.h>
+#include "arkanoid.h"
+
+/**
+ * @brief Autopilot error model.
+ */
+typedef struct {
+    uint8_t max_error;              ///< Largest aiming error in pixels, drawn anew for every approach of the ball.
+    uint8_t max_step;               ///< Largest paddle movement per tick in pixels (0 = unlimited).
+} AutopilotConfig;
+
+/**
+ * @brief Default error model of the attract mode.
+ */
+#define AUTOPILOT_DEMO_ERROR 7      ///< Aiming error of the demo player in pixels (varies the bounce angle).
+#define AUTOPILOT_DEMO_STEP 3       ///< Paddle speed of the demo player in pixels per tick.
+
+/**
+ * @brief Resets the autopilot.
+ *
+ * @param config Error model (copied).
+ * @param seed Seed of the aiming error; equal seeds give equal games.
+ */
+void autopilot_init(const AutopilotConfig* config, uint32_t seed);
+
+/**
+ * @brief Predicts where the next ball reaches the paddle line.
+ *
+ * Of the balls moving down, the one arriving first is followed in a
+ * straight line with reflections off the side walls; blocks are ignored
+ * since they lie above the paddle. Costs one division per ball.
+ *
+ * @param balls Pointer to the ball pool.
+ * @param paddle Pointer to the paddle structure.
+ * @param x Filled with the predicted x of the ball at the paddle line.
+ * @return Ticks until the crossing, -1 if no ball is moving down.
+ */
+int autopilot_predict(const BallPool* balls, const Paddle* paddle, uint8_t* x);
+
+/**
+ * @brief Computes the slider value that moves the paddle under the ball.
+ *
+ * The result can be passed to paddle_update() in place of the TSI value.
+ *
+ * @param balls Pointer to the ball pool.
+ * @param paddle Pointer to the paddle structure.
+ * @return Slider value (1-100 scale).
+ */
+uint8_t autopilot_input(const BallPool* balls, const Paddle* paddle);
+
+#endif // AUTOPILOT_H
@@ -0,0 +1,21 @@
+// Generated by tools/gen_block_masks.py from Fonts.c - do not edit.
+#include "arkanoid.h"
+
+#if BLOCK_WIDTH != 12 || BLOCK_HEIGHT != 6
+#error "block_masks.c is out of date, run tools/gen_block_masks.py"
+#endif
+
+const uint8_t block_masks[BLOCK_TYPE_COUNT][BLOCK_WIDTH] = {
+    {0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F}, // block_bitmap_1
+    {0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F}, // block_bitmap_2
+    {0x3F, 0x00, 0x3F, 0x00, 0x3F, 0x00, 0x3F, 0x00, 0x3F, 0x00, 0x3F, 0x00}, // block_bitmap_3
+    {0x20, 0x1F, 0x20, 0x1F, 0x20, 0x1F, 0x20, 0x1F, 0x20, 0x1F, 0x20, 0x1F}, // block_bitmap_4
+    {0x1F, 0x20, 0x00, 0x00, 0x00, 0x00, 0x20, 0x1F, 0x1F, 0x20, 0x00, 0x00}, // block_bitmap_5
+    {0x3F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x3F, 0x1F, 0x1F, 0x1F}, // block_bitmap_6
+    {0x3F, 0x11, 0x15, 0x11, 0x11, 0x15, 0x11, 0x3F, 0x3F, 0x11, 0x15, 0x11}, // block_bitmap_stone
+    {0x15, 0x2A, 0x15, 0x2A, 0x15, 0x2A, 0x15, 0x2A, 0x15, 0x2A, 0x15, 0x2A}, // block_bitmap_steel
+    {0x11, 0x2A, 0x04, 0x00, 0x00, 0x04, 0x2A, 0x11, 0x11, 0x2A, 0x04, 0x00}, // block_bitmap_wood
+    {0x3F, 0x1B, 0x11, 0x15, 0x15, 0x11, 0x1B, 0x3F, 0x3F, 0x1B, 0x11, 0x15}  // block_bitmap_shaded
+};
+
+const uint16_t block_masks_solid = 0x0001;
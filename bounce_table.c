@@ -0,0 +1,25 @@
+// Generated by tools/gen_bounce_table.py - do not edit.
+#include "arkanoid.h"
+
+#if BOUNCE_ANGLES != 16
+#error "bounce_table.c is out of date, run tools/gen_bounce_table.py"
+#endif
+
+const BounceDir bounce_dirs[BOUNCE_ANGLES] = {
+    {-108,  -69}, // -57.19 deg
+    {-100,  -80}, // -51.56 deg
+    { -92,  -89}, // -45.94 deg
+    { -83,  -98}, // -40.31 deg
+    { -73, -105}, // -34.69 deg
+    { -62, -112}, // -29.06 deg
+    { -51, -117}, // -23.44 deg
+    { -39, -122}, // -17.81 deg
+    {  39, -122}, // +17.81 deg
+    {  51, -117}, // +23.44 deg
+    {  62, -112}, // +29.06 deg
+    {  73, -105}, // +34.69 deg
+    {  83,  -98}, // +40.31 deg
+    {  92,  -89}, // +45.94 deg
+    { 100,  -80}, // +51.56 deg
+    { 108,  -69}  // +57.19 deg
+};
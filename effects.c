@@ -0,0 +1,77 @@
+#include "effects.h"
+#include "oled.h"
+#include "Fonts.h"
+
+#if (MAX_EFFECTS & (MAX_EFFECTS - 1)) != 0
+#error "MAX_EFFECTS must be a power of two"
+#endif
+
+// Animation frames of a destroyed block
+static const uint8_t* const effect_frames[EFFECT_FRAMES] = {
+    block_animation_frame_1, block_animation_frame_2, block_animation_frame_3,
+    block_animation_frame_4, block_animation_frame_5, block_animation_frame_6
+};
+
+static Effect effects[MAX_EFFECTS];  // Ring buffer, oldest effect at effects_head
+static uint8_t effects_head = 0;
+static uint8_t effects_count = 0;
+static uint16_t frame_clock = 0;
+
+#define EFFECT_AT(k) (&effects[(effects_head + (k)) & (MAX_EFFECTS - 1)])
+
+// Mark the area of an effect for upload
+static void mark_effect(const Effect* effect) {
+    ssd1306_mark_dirty(effect->x, effect->y, EFFECT_WIDTH, EFFECT_HEIGHT);
+}
+
+// Drop all effects
+void effects_init(void) {
+    effects_head = 0;
+    effects_count = 0;
+}
+
+// Add an effect, dropping the oldest when the ring is full
+void effect_spawn(uint8_t x, uint8_t y) {
+    if (effects_count == MAX_EFFECTS) {
+        mark_effect(EFFECT_AT(0)); // Erase the dropped one
+        effects_head = (effects_head + 1) & (MAX_EFFECTS - 1);
+        effects_count--;
+    }
+
+    Effect* effect = EFFECT_AT(effects_count);
+    effect->x = x;
+    effect->y = y;
+    effect->frame = 0;
+    effect->start = frame_clock;
+    effects_count++;
+    mark_effect(effect);
+}
+
+// Advance the frame clock; effects only dirty their own rectangle when their frame changes
+void effects_update(void) {
+    frame_clock++;
+
+    for (uint8_t k = 0; k < effects_count; k++) {
+        Effect* effect = EFFECT_AT(k);
+        uint8_t frame = (uint8_t)((uint16_t)(frame_clock - effect->start) / EFFECT_FRAME_TICKS);
+
+        if (frame != effect->frame) {
+            effect->frame = frame;
+            mark_effect(effect);
+        }
+    }
+
+    // All effects last equally long, so they finish in ring order
+    while (effects_count > 0 && EFFECT_AT(0)->frame >= EFFECT_FRAMES) {
+        effects_head = (effects_head + 1) & (MAX_EFFECTS - 1);
+        effects_count--;
+    }
+}
+
+// Draw the current frame of each effect
+void draw_effects(void) {
+    for (uint8_t k = 0; k < effects_count; k++) {
+        const Effect* effect = EFFECT_AT(k);
+        draw_bitmap(effect->x, effect->y, effect_frames[effect->frame], EFFECT_WIDTH, EFFECT_HEIGHT - 1); // Frames have 5 rows
+    }
+}
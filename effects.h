@@ -0,0 +1,52 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <stdint.h>
+
+/**
+ * @brief Block destruction animation parameters.
+ */
+#define MAX_EFFECTS 4               ///< Ring buffer capacity (power of two); the oldest effect is dropped when full.
+#define EFFECT_FRAMES 6             ///< Number of animation frames (block_animation_frame_1..6).
+#define EFFECT_FRAME_TICKS 3        ///< Frame clock ticks each animation frame stays on screen.
+#define EFFECT_WIDTH 12             ///< Width of an effect in pixels (one block).
+#define EFFECT_HEIGHT 6             ///< Height of an effect in pixels (one block).
+
+/**
+ * @brief Structure representing a running animation.
+ */
+typedef struct {
+    uint8_t x, y;                   ///< Position of the animation.
+    uint8_t frame;                  ///< Animation frame currently shown.
+    uint16_t start;                 ///< Frame clock value when the animation started.
+} Effect;
+
+/**
+ * @brief Removes all running effects.
+ */
+void effects_init(void);
+
+/**
+ * @brief Starts a block destruction animation.
+ *
+ * If the ring is full the oldest effect is dropped to make room.
+ *
+ * @param x X-coordinate of the destroyed block.
+ * @param y Y-coordinate of the destroyed block.
+ */
+void effect_spawn(uint8_t x, uint8_t y);
+
+/**
+ * @brief Advances the frame clock by one frame.
+ *
+ * Effects whose frame changes mark their own rectangle dirty; finished
+ * effects are removed.
+ */
+void effects_update(void);
+
+/**
+ * @brief Draws all running effects.
+ */
+void draw_effects(void);
+
+#endif // EFFECTS_H
@@ -0,0 +1,53 @@
+#include "event_queue.h"
+
+#if (EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) != 0 || EVENT_QUEUE_SIZE > 128
+#error "EVENT_QUEUE_SIZE must be a power of two no larger than 128"
+#endif
+
+// Keep the compiler from moving slot accesses across index updates (Cortex-M0+ has no reordering to fence)
+#define EVENT_BARRIER() __asm volatile ("" ::: "memory")
+
+// Free-running indices: head is written only by the producer, tail only by the consumer
+static Event event_ring[EVENT_QUEUE_SIZE];
+static volatile uint8_t event_head = 0;
+static volatile uint8_t event_tail = 0;
+volatile uint8_t event_overflows = 0;
+
+// Drop all queued events
+void event_queue_init(void) {
+    event_head = 0;
+    event_tail = 0;
+    event_overflows = 0;
+}
+
+// Producer side: fill the slot, then publish it by advancing head
+int event_post(EventType type, uint8_t arg) {
+    uint8_t head = event_head;
+
+    if ((uint8_t)(head - event_tail) >= EVENT_QUEUE_SIZE) {
+        event_overflows++;
+        return 0;
+    }
+
+    Event* slot = &event_ring[head & (EVENT_QUEUE_SIZE - 1)];
+    slot->type = (uint8_t)type;
+    slot->arg = arg;
+    EVENT_BARRIER();
+    event_head = (uint8_t)(head + 1);
+    return 1;
+}
+
+// Consumer side: read the slot, then release it by advancing tail
+int event_poll(Event* event) {
+    uint8_t tail = event_tail;
+
+    if (tail == event_head) {
+        return 0;
+    }
+
+    EVENT_BARRIER();
+    *event = event_ring[tail & (EVENT_QUEUE_SIZE - 1)];
+    EVENT_BARRIER();
+    event_tail = (uint8_t)(tail + 1);
+    return 1;
+}
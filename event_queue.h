@@ -0,0 +1,64 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Event queue parameters.
+ */
+#define EVENT_QUEUE_SIZE 64         ///< Ring capacity (power of two, at most 128).
+
+/**
+ * @brief Types of game events.
+ */
+typedef enum {
+    EVENT_BLOCK_DESTROYED,          ///< A block was destroyed, arg = cell index.
+    EVENT_SCORE_CHANGED,            ///< Points were scored, arg = points added.
+    EVENT_LIFE_LOST,                ///< The last ball drained, arg = lives left.
+    EVENT_LIFE_GAINED,              ///< An extra life was caught, arg = lives left.
+    EVENT_MAP_CLEARED,              ///< The last block of the map was destroyed, arg = map number.
+    EVENT_PADDLE_MOVED              ///< The paddle moved, arg = new x of the paddle.
+} EventType;
+
+/**
+ * @brief Structure representing a queued event.
+ */
+typedef struct {
+    uint8_t type;                   ///< Event type (see EventType).
+    uint8_t arg;                    ///< Event argument, meaning depends on the type.
+} Event;
+
+/**
+ * @brief Number of events dropped because the queue was full.
+ */
+extern volatile uint8_t event_overflows;
+
+/**
+ * @brief Empties the queue.
+ *
+ * Must not run concurrently with event_post() or event_poll().
+ */
+void event_queue_init(void);
+
+/**
+ * @brief Appends an event to the queue.
+ *
+ * Lock-free for a single producer, which may be an interrupt handler, and a
+ * single consumer. When the queue is full the event is dropped and counted
+ * in event_overflows.
+ *
+ * @param type Event type.
+ * @param arg Event argument.
+ * @return 1 if the event was queued, 0 if it was dropped.
+ */
+int event_post(EventType type, uint8_t arg);
+
+/**
+ * @brief Takes the oldest event from the queue.
+ *
+ * @param event Filled with the event.
+ * @return 1 if an event was taken, 0 if the queue is empty.
+ */
+int event_poll(Event* event);
+
+#endif // EVENT_QUEUE_H
@@ -2,15 +2,19 @@
 #include "MKL05Z4.h"
 #include <stdio.h>
 
+// Komunikaty diagnostyczne tylko w buildzie z FLASH_DEBUG (printf bez retargetu zatrzymuje gr)
+#ifdef FLASH_DEBUG
+#define FLASH_LOG(...) printf(__VA_ARGS__)
+#else
+#define FLASH_LOG(...) ((void)0)
+#endif
+
 // Oczekiwane kody statusu
 #define FLASH_CMD_SUCCESS 0x80
 #define FLASH_CMD_ACCERR  0x20
 #define FLASH_CMD_FPVIOL  0x10
 #define FLASH_CMD_MGSTAT0 0x01
 
-// Rozmiar sektora pamici Flash
-#define FLASH_SECTOR_SIZE 1024
-
 // Funkcja czekajca na zakoczenie operacji Flash
 static void wait_for_flash(void) {
     while (!(FTFA->FSTAT & FLASH_CMD_SUCCESS)) {
@@ -25,11 +29,11 @@ static void clear_flash_errors(void) {
 
 // Funkcja do wymazywania sektora Flash
 bool Flash_EraseSector(uint32_t address) {
-    printf("Erasing Flash Sector: Address = 0x%08X\n", address);
+    FLASH_LOG("Erasing Flash Sector: Address = 0x%08X\n", address);
 
     // Sprawdzenie wyrwnania adresu do granicy sektora
     if (address % FLASH_SECTOR_SIZE != 0) {
-        printf("Error: Address not aligned to sector boundary.\n");
+        FLASH_LOG("Error: Address not aligned to sector boundary.\n");
         return false;
     }
 
@@ -47,21 +51,21 @@ bool Flash_EraseSector(uint32_t address) {
 
     // Sprawdzenie bdw
     if (FTFA->FSTAT & (FLASH_CMD_ACCERR | FLASH_CMD_FPVIOL | FLASH_CMD_MGSTAT0)) {
-        printf("Error: Flash erase failed (FSTAT=0x%02X).\n", FTFA->FSTAT);
+        FLASH_LOG("Error: Flash erase failed (FSTAT=0x%02X).\n", FTFA->FSTAT);
         return false;
     }
 
-    printf("Flash sector erased successfully.\n");
+    FLASH_LOG("Flash sector erased successfully.\n");
     return true;
 }
 
 // Funkcja do zapisu danych do Flash
 bool Flash_Write(uint32_t address, const uint8_t* data, uint32_t size) {
-    printf("Writing to Flash: Address = 0x%08X, Size = %d\n", address, size);
+    FLASH_LOG("Writing to Flash: Address = 0x%08X, Size = %d\n", address, size);
 
     // Sprawdzenie poprawnoci rozmiaru danych
     if (size % 4 != 0) {
-        printf("Error: Data size must be a multiple of 4.\n");
+        FLASH_LOG("Error: Data size must be a multiple of 4.\n");
         return false;
     }
 
@@ -84,49 +88,49 @@ bool Flash_Write(uint32_t address, const uint8_t* data, uint32_t size) {
 
         // Sprawdzenie bdw
         if (FTFA->FSTAT & (FLASH_CMD_ACCERR | FLASH_CMD_FPVIOL | FLASH_CMD_MGSTAT0)) {
-            printf("Error: Flash write failed (FSTAT=0x%02X).\n", FTFA->FSTAT);
+            FLASH_LOG("Error: Flash write failed (FSTAT=0x%02X).\n", FTFA->FSTAT);
             return false;
         }
 
-        printf("Written word at 0x%08X: 0x%02X%02X%02X%02X\n",
+        FLASH_LOG("Written word at 0x%08X: 0x%02X%02X%02X%02X\n",
                address, data[i], data[i + 1], data[i + 2], data[i + 3]);
 
         address += 4; // Przesunicie do kolejnego adresu
     }
 
-    printf("Flash write completed successfully.\n");
+    FLASH_LOG("Flash write completed successfully.\n");
     return true;
 }
 
 // Funkcja do odczytu danych z Flash
 bool Flash_Read(uint32_t address, uint8_t* buffer, uint32_t size) {
-    printf("Reading from Flash: Address = 0x%08X, Size = %d\n", address, size);
+    FLASH_LOG("Reading from Flash: Address = 0x%08X, Size = %d\n", address, size);
 
     for (uint32_t i = 0; i < size; i++) {
         buffer[i] = *((volatile uint8_t*)(address + i));
     }
 
-    printf("Read completed: ");
+    FLASH_LOG("Read completed: ");
     for (uint32_t i = 0; i < size; i++) {
-        printf("0x%02X ", buffer[i]);
+        FLASH_LOG("0x%02X ", buffer[i]);
     }
-    printf("\n");
+    FLASH_LOG("\n");
 
     return true;
 }
 
 // Funkcja sprawdzajca, czy sektor Flash jest wymazany
 bool Flash_IsErased(uint32_t address, uint32_t size) {
-    printf("Checking if Flash sector is erased: Address = 0x%08X, Size = %d\n", address, size);
+    FLASH_LOG("Checking if Flash sector is erased: Address = 0x%08X, Size = %d\n", address, size);
 
     for (uint32_t i = 0; i < size; i += 4) {
         uint32_t value = *((volatile uint32_t*)(address + i));
         if (value != 0xFFFFFFFF) {
-            printf("Flash not erased at 0x%08X: 0x%08X\n", address + i, value);
+            FLASH_LOG("Flash not erased at 0x%08X: 0x%08X\n", address + i, value);
             return false;
         }
     }
 
-    printf("Flash sector is erased.\n");
+    FLASH_LOG("Flash sector is erased.\n");
     return true;
 }
@@ -4,6 +4,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Rozmiar sektora pamici Flash
+#define FLASH_SECTOR_SIZE 1024
+
 // Prototypy funkcji
 bool Flash_EraseSector(uint32_t address);
 bool Flash_Write(uint32_t address, const uint8_t* data, uint32_t size);
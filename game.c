@@ -4,42 +4,181 @@
 #include "arkanoid.h"
 #include "maps.h"
 #include "tsi.h"
+#include "keyboard.h"
+#include "menu.h"
 #include "spi.h"
 #include "scores.h"
+#include "powerup.h"
+#include "effects.h"
+#include "event_queue.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "autopilot.h"
+#include <stddef.h>
 
-void start_game(const char* nickname) {
-		//Inits
-    game_init();
-    Paddle paddle = { (SCREEN_WIDTH - PADDLE_WIDTH) / 2, SCREEN_HEIGHT - PADDLE_HEIGHT - 5 };
-    Ball ball = { (SCREEN_WIDTH / 2) - BALL_SIZE, SCREEN_HEIGHT - PADDLE_HEIGHT - BALL_SIZE - 5, 1, -1 };
+// Paddle and balls of the running game, static: the collision sweep under the game loop needs the stack
+static Paddle game_paddle;
+static BallPool game_balls;
+
+// Hand queued game events to their consumers; returns 1 on game over
+static int dispatch_events(const char* nickname) {
+    Event event;
+    Event cleared = { EVENT_MAP_CLEARED, 0 };
+    int cleared_posted = 0;
 
-    draw_game(&paddle, &ball);
+    while (event_poll(&event)) {
+        switch (event.type) {
+            case EVENT_BLOCK_DESTROYED:
+                powerup_block_destroyed(event.arg);
+                effect_spawn(BLOCK_X(event.arg % MAP_WIDTH), BLOCK_Y(event.arg / MAP_WIDTH));
+                break;
+            case EVENT_MAP_CLEARED:
+                cleared = event;
+                cleared_posted = 1;
+                continue; // Drawn once the next map is loaded
+            default:
+                break;
+        }
+        draw_event(&event);
+    }
+
+    // The game state decides, the events only notify: a full queue drops them
+    if (check_map_complete()) {
+        load_next_map();
+        if (cleared_posted) {
+            draw_event(&cleared);
+        } else {
+            draw_invalidate(); // Upload the whole new map
+        }
+    }
+    if (get_lives() <= 0) { //game over, save the score
+        if (nickname != NULL) {
+            update_top_scores(nickname, get_score());
+        }
+        return 1;
+    }
+    return 0;
+}
+
+// Game loop shared by new, resumed and demo games; returns 1 if the game was suspended or the demo stopped
+static int game_loop(const char* nickname, Paddle* paddle, BallPool* balls, int demo) {
+    int fixed_clock = (replay_mode() != REPLAY_OFF); // Kept after a full recording ends, so timers run on
+    uint32_t game_time = 0;
+
+    snapshot_power_init();
+    effects_init();
+    view_update(paddle, balls);
+    draw_invalidate();
+    draw_game(paddle, balls);
 
     while (1) {
-        // Get touchpad
+        // Get touchpad and keys, a replay records or replaces them. Replays run on a clock of fixed ticks.
         uint8_t touch_pos = TSI_ReadSlider();
+        uint8_t key = Keyboard_ReadKey();
+        uint32_t now = fixed_clock ? (game_time += REPLAY_TICK_MS) : millis();
 
-        if (touch_pos != 0) {
-            paddle_update(&paddle, touch_pos);
+        // Demo: the autopilot plays until any key is pressed
+        if (demo) {
+            if (key != 0xFF) {
+                return 1;
+            }
+            touch_pos = autopilot_input(balls, paddle);
         }
 
-        ball_update(&ball, &paddle);
-
-        if (check_map_complete()) {
-            load_next_map();
+        if (!replay_input(&touch_pos, &key)) {
+            int playing = (replay_mode() == REPLAY_PLAY);
+            replay_finish(replay_state_hash(paddle, balls));
+            if (playing) {
+                return 0; // End of the recording
+            }
         }
 
-        if (ball.y > SCREEN_HEIGHT) {
-            lives--; //game over  
-            if (lives <= 0) {
-                update_top_scores(nickname, get_score());
-                game_over_display();
-                break;
+        // Pause key or failing supply: save the game between frames and leave
+        if (snapshot_power_low || (key != 0xFF && key_map[key / 3][key % 3][0] == '#')) {
+            int playing = (replay_mode() == REPLAY_PLAY);
+            replay_finish(replay_state_hash(paddle, balls));
+            if (!playing) {
+                snapshot_save(paddle, balls);
             }
-            reset_ball(&ball, &paddle);
+            snapshot_power_low = 0;
+            return 1;
+        }
+
+        if (touch_pos != 0) {
+            paddle_update(paddle, touch_pos);
         }
 
-        draw_game(&paddle, &ball);
+        if (game_state == GAME_STATE_SERVE && key != 0xFF) {
+            ball_launch(balls); // Any key launches the served ball early
+        }
+
+        ball_pool_update(balls, paddle, now);
+        powerup_update(paddle, balls, now);
+
+        // Playback never touches the score board
+        if (dispatch_events(replay_mode() == REPLAY_PLAY ? NULL : nickname)) {
+            replay_finish(replay_state_hash(paddle, balls));
+            return 0;
+        }
+
+        view_update(paddle, balls);
+        draw_game(paddle, balls);
+        map_prepare(); // Idle until the delay: get the next map ready for a hitch-free switch
         for (volatile int i = 0; i < game_speed * 1000; i++); //DELAY for diffrent game speed
     }
 }
+
+// Run a game, then hand the menus an unscrolled screen
+static int run_game(const char* nickname, int demo) {
+    int result = game_loop(nickname, &game_paddle, &game_balls, demo);
+
+    ssd1306_set_view(0);
+    return result;
+}
+
+int start_game(const char* nickname, ReplayMode mode) {
+		//Inits
+    event_queue_init();
+    if (mode != REPLAY_PLAY) {
+        game_seed = millis();
+    }
+    game_init();
+    replay_start(mode);
+    Ball ball = { (SCREEN_WIDTH / 2) - BALL_SIZE, PADDLE_VIEW_Y - BALL_SIZE, 0, 0, 0, 0 };
+
+    game_paddle = (Paddle){ (SCREEN_WIDTH - PADDLE_WIDTH) / 2, PADDLE_VIEW_Y, PADDLE_WIDTH };
+    ball_aim(&ball, BOUNCE_SERVE_ANGLE);
+    ball_pool_init(&game_balls, &ball);
+    return run_game(nickname, 0);
+}
+
+int resume_game(const char* nickname) {
+    event_queue_init();
+    game_init();
+    replay_start(REPLAY_OFF); // Resumed games are not recorded
+    if (!snapshot_load(&game_paddle, &game_balls, millis())) {
+        return 0;
+    }
+    snapshot_clear(); // A snapshot resumes only once
+    return run_game(nickname, 0);
+}
+
+void start_demo(void) {
+    AutopilotConfig config = { AUTOPILOT_DEMO_ERROR, AUTOPILOT_DEMO_STEP };
+    int stopped;
+
+    // Attract mode: new games back to back until a key is pressed
+    do {
+        event_queue_init();
+        game_seed = millis();
+        game_init();
+        replay_start(REPLAY_OFF);
+        autopilot_init(&config, game_seed);
+        Ball ball = { (SCREEN_WIDTH / 2) - BALL_SIZE, PADDLE_VIEW_Y - BALL_SIZE, 0, 0, 0, 0 };
+
+        game_paddle = (Paddle){ (SCREEN_WIDTH - PADDLE_WIDTH) / 2, PADDLE_VIEW_Y, PADDLE_WIDTH };
+        ball_aim(&ball, BOUNCE_SERVE_ANGLE);
+        ball_pool_init(&game_balls, &ball);
+        stopped = run_game(NULL, 1);
+    } while (!stopped);
+}
@@ -1,6 +1,10 @@
 #ifndef GAME_H
 #define GAME_H
 
-void start_game(const char* nickname); //Game start 
+#include "replay.h"
+
+int start_game(const char* nickname, ReplayMode mode); //Game start, returns 1 if the game was suspended to flash, 0 on game over or at the end of a replay
+int resume_game(const char* nickname); //Continue the game saved in flash, returns like start_game (0 if there is nothing to resume)
+void start_demo(void); //Attract mode: the autopilot plays until a key is pressed
 
 #endif // GAME_H
@@ -2,11 +2,115 @@
 #include "oled.h"
 #include "Fonts.h"
 #include "flash.h"
+#include "powerup.h"
+#include "effects.h"
+#include "event_queue.h"
 #include <stdio.h>
 
+#define HUD_HEIGHT 8 // Lives and score row at the top of the screen
+#define MAX_MOVING_RECTS (1 + MAX_BALLS + MAX_CAPSULES) // Paddle, balls and capsules
+
+// Screen area of a moving sprite
+typedef struct {
+    uint8_t x, y, w, h;
+} Rect;
+
+// Moving sprites drawn in the previous and in the current frame
+static Rect prev_rects[MAX_MOVING_RECTS];
+static Rect cur_rects[MAX_MOVING_RECTS];
+static uint8_t prev_count = 0;
+static uint8_t cur_count = 0;
+static uint8_t drawn_view = 0; // View top of the frame on the display
+static Rect fixed_layer;       // Indestructible blocks of the current map, still on screen when it is cleared
+
+// Draw a moving sprite and remember where it went
+static void draw_moving(uint8_t x, uint8_t y, const uint8_t* bitmap, uint8_t w, uint8_t h) {
+    draw_bitmap(x, y, bitmap, w, h);
+    if (cur_count < MAX_MOVING_RECTS) {
+        Rect* rect = &cur_rects[cur_count++];
+        rect->x = x;
+        rect->y = y;
+        rect->w = w;
+        rect->h = h;
+    }
+}
+
+// Find the area covered by the blocks of the current map, or by its indestructible ones only
+static void find_block_layer(Rect* layer, int indestructible) {
+    uint16_t cols = 0;
+    uint8_t first = MAP_HEIGHT, last = 0;
+
+    layer->w = 0;
+    for (uint8_t row = 0; row < MAP_HEIGHT; row++) {
+        uint16_t bits = block_rows[row];
+        for (uint16_t rest = indestructible ? bits : 0; rest; rest &= rest - 1) {
+            uint8_t type = block_get_type(BLOCK_INDEX(row, BLOCK_ROW_FIRST(rest)));
+            if (type >= BLOCK_TYPE_COUNT || block_hits[type] != BLOCK_INDESTRUCTIBLE) {
+                bits &= (uint16_t)~(rest & -rest);
+            }
+        }
+        if (bits) {
+            cols |= bits;
+            if (first == MAP_HEIGHT) first = row;
+            last = row;
+        }
+    }
+    if (cols == 0) {
+        return;
+    }
+
+    uint8_t col0 = BLOCK_ROW_FIRST(cols);
+    uint8_t col1 = (uint8_t)(31 - __builtin_clz(cols));
+    layer->x = BLOCK_X(col0);
+    layer->y = BLOCK_Y(first);
+    layer->w = BLOCK_X(col1) - BLOCK_X(col0) + BLOCK_WIDTH;
+    layer->h = BLOCK_Y(last) - BLOCK_Y(first) + BLOCK_HEIGHT;
+}
+
+// Mark a block layer for upload
+static void mark_block_layer(const Rect* layer) {
+    if (layer->w != 0) {
+        ssd1306_mark_dirty(layer->x, layer->y, layer->w, layer->h);
+    }
+}
+
+void draw_invalidate(void) {
+    // Upload the whole screen with the next frame
+    ssd1306_set_view(view_top);
+    drawn_view = view_top;
+    ssd1306_mark_dirty(0, view_top, SCREEN_WIDTH, SCREEN_HEIGHT);
+    find_block_layer(&fixed_layer, 1);
+}
+
+void draw_event(const Event* event) {
+    Rect layer;
+
+    // Upload only what the event changed
+    switch (event->type) {
+        case EVENT_BLOCK_DESTROYED:
+            ssd1306_mark_dirty(BLOCK_X(event->arg % MAP_WIDTH), BLOCK_Y(event->arg / MAP_WIDTH), BLOCK_WIDTH, BLOCK_HEIGHT);
+            break;
+        case EVENT_SCORE_CHANGED:
+        case EVENT_LIFE_LOST:
+        case EVENT_LIFE_GAINED:
+            ssd1306_mark_dirty(0, view_top, SCREEN_WIDTH, HUD_HEIGHT);
+            break;
+        case EVENT_MAP_CLEARED:
+            // Destroyed blocks were uploaded as they went, so of the old map only
+            // the indestructible ones are left on screen
+            mark_block_layer(&fixed_layer);
+            find_block_layer(&layer, 0);
+            mark_block_layer(&layer);
+            find_block_layer(&fixed_layer, 1);
+            break;
+        default:
+            break;
+    }
+}
+
 void draw_paddle(Paddle* paddle) {
     // Draw the paddle at its current position
-    draw_bitmap(paddle->x, paddle->y, paddle_bitmap, PADDLE_WIDTH, PADDLE_HEIGHT);
+    draw_moving(paddle->x, paddle->y, paddle_bitmap, paddle->width, PADDLE_HEIGHT);
 }
 
 void draw_ball(Ball* ball) {
@@ -14,20 +118,64 @@ void draw_ball(Ball* ball) {
     draw_bitmap(ball->x, ball->y, ball_bitmap, BALL_SIZE, BALL_SIZE);
 }
 
-void draw_block(Block* block) {
+void draw_balls(const BallPool* balls) {
+    // Draw each ball that is still in play
+    for (uint16_t bits = balls->active; bits; bits &= bits - 1) {
+        uint8_t i = (uint8_t)__builtin_ctz(bits);
+        draw_moving(balls->x[i], balls->y[i], ball_bitmap, BALL_SIZE, BALL_SIZE);
+    }
+}
+
+void draw_capsules(void) {
+    // Draw each falling power-up capsule with its type's bitmap
+    for (uint8_t bits = capsule_active; bits; bits &= bits - 1) {
+        const Capsule* capsule = &capsules[__builtin_ctz(bits)];
+        const uint8_t* bitmap = capsule_bitmap_expand;
+
+        if (capsule->type == POWERUP_EXTRA_LIFE) {
+            bitmap = capsule_bitmap_life;
+        } else if (capsule->type == POWERUP_MULTIBALL) {
+            bitmap = capsule_bitmap_multi;
+        }
+        draw_moving(capsule->x, capsule->y, bitmap, CAPSULE_WIDTH, CAPSULE_HEIGHT);
+    }
+}
+
+void draw_block(uint8_t row, uint8_t col) {
+    uint8_t x = BLOCK_X(col);
+    uint8_t y = BLOCK_Y(row);
+
     // Draw a block based on its type
-    switch (block->type) {
+    switch ((BlockType)block_get_type(BLOCK_INDEX(row, col))) {
         case BLOCK_TYPE_1: 
-            draw_bitmap(block->x, block->y, block_bitmap_1, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            draw_bitmap(x, y, block_bitmap_1, BLOCK_WIDTH, BLOCK_HEIGHT); 
             break;
         case BLOCK_TYPE_2: 
-            draw_bitmap(block->x, block->y, block_bitmap_2, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            draw_bitmap(x, y, block_bitmap_2, BLOCK_WIDTH, BLOCK_HEIGHT); 
             break;
         case BLOCK_TYPE_3: 
-            draw_bitmap(block->x, block->y, block_bitmap_3, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            draw_bitmap(x, y, block_bitmap_3, BLOCK_WIDTH, BLOCK_HEIGHT); 
             break;
         case BLOCK_TYPE_4: 
-            draw_bitmap(block->x, block->y, block_bitmap_4, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            draw_bitmap(x, y, block_bitmap_4, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            break;
+        case BLOCK_TYPE_5: 
+            draw_bitmap(x, y, block_bitmap_5, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            break;
+        case BLOCK_TYPE_6: 
+            draw_bitmap(x, y, block_bitmap_6, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            break;
+        case BLOCK_TYPE_STONE: 
+            draw_bitmap(x, y, block_bitmap_stone, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            break;
+        case BLOCK_TYPE_STEEL: 
+            draw_bitmap(x, y, block_bitmap_steel, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            break;
+        case BLOCK_TYPE_WOOD: 
+            draw_bitmap(x, y, block_bitmap_wood, BLOCK_WIDTH, BLOCK_HEIGHT); 
+            break;
+        case BLOCK_TYPE_SHADED: 
+            draw_bitmap(x, y, block_bitmap_shaded, BLOCK_WIDTH, BLOCK_HEIGHT); 
             break;
         default:
             break;
@@ -35,33 +183,61 @@ void draw_block(Block* block) {
 }
 
 void draw_blocks(void) {
-    // Iterate through all blocks and draw only active ones
-    for (int i = 0; i < NUM_BLOCKS; i++) {
-        if (blocks[i].is_active) {
-            draw_block(&blocks[i]);
+    // Walk the set bits of each row mask so only active blocks in play are visited
+    for (uint8_t row = view_first_row; row < MAP_HEIGHT; row++) {
+        for (uint16_t bits = block_rows[row]; bits; bits &= bits - 1) {
+            draw_block(row, BLOCK_ROW_FIRST(bits));
         }
     }
 }
 
-void draw_game(Paddle* paddle, Ball* ball) {
+void draw_game(Paddle* paddle, const BallPool* balls) {
+    // Follow the view: a one pixel scroll moves the display start line, so only
+    // the HUD and the rows that slid under it need uploading
+    if (view_top != drawn_view) {
+        if (view_top + 1 == drawn_view) {
+            ssd1306_set_view(view_top);
+            drawn_view = view_top;
+            ssd1306_mark_dirty(0, view_top, SCREEN_WIDTH, PLAYFIELD_TOP + BLOCK_PITCH_Y);
+        } else {
+            draw_invalidate();
+        }
+    }
+
     // Clear the OLED screen before drawing game elements
     ssd1306_clear_screen(0x00);
 
-    // Draw the lives icon and count
-    draw_bitmap(2, 0, block_bitmap_heart, 8, 8); // Heart icon
-    draw_digit(12, 0, (uint8_t)get_lives());
+    // Draw the lives icon and count (the HUD stays at the top of the view)
+    draw_bitmap(2, view_top, block_bitmap_heart, 8, 8); // Heart icon
+    draw_digit(12, view_top, (uint8_t)get_lives());
 
     // Draw the score icon and current score
-    draw_bitmap(64, 0, star_bitmap, 8, 8); // Star icon
-    draw_number(80, 0, get_score());
+    draw_bitmap(64, view_top, star_bitmap, 8, 8); // Star icon
+    draw_number(80, view_top, get_score());
 
-    // Draw game elements: paddle, ball, and blocks
+    // Draw game elements: paddle, balls, and blocks
+    cur_count = 0;
     draw_paddle(paddle);
-    draw_ball(ball);
+    draw_balls(balls);
     draw_blocks();
+    draw_capsules();
 
-    // Refresh the screen to apply changes
-    ssd1306_refresh_gram();
+    // Block animations go on top and dirty their own rectangles
+    effects_update();
+    draw_effects();
+
+    // Moving sprites dirty both where they were and where they are now
+    for (uint8_t i = 0; i < prev_count; i++) {
+        ssd1306_mark_dirty(prev_rects[i].x, prev_rects[i].y, prev_rects[i].w, prev_rects[i].h);
+    }
+    for (uint8_t i = 0; i < cur_count; i++) {
+        ssd1306_mark_dirty(cur_rects[i].x, cur_rects[i].y, cur_rects[i].w, cur_rects[i].h);
+        prev_rects[i] = cur_rects[i];
+    }
+    prev_count = cur_count;
+
+    // Upload only the changed parts of the screen
+    ssd1306_refresh_dirty();
 }
 
 void game_over_display(void) {
@@ -77,7 +253,4 @@ void game_over_display(void) {
 
     // Refresh the screen to show the "Game Over" display
     ssd1306_refresh_gram();
-
-    // Delay for a moment before allowing further action
-    for (volatile uint32_t delay = 0; delay < 10000000; delay++);
 }
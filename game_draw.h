@@ -2,11 +2,34 @@
 #define GAME_DRAW_H
 
 #include "arkanoid.h"
+#include "event_queue.h"
 
 /**
  * @brief Functions for rendering game elements on the screen.
  */
 
+/**
+ * @brief Forces the next draw_game() to upload the whole screen.
+ *
+ * Needed whenever the screen changes outside the tracked sprites, e.g.
+ * when a new map is loaded.
+ */
+void draw_invalidate(void);
+
+/**
+ * @brief Marks the screen areas changed by a game event for upload.
+ *
+ * Destroyed blocks dirty their own cell and score and life changes dirty
+ * the HUD. A cleared map dirties only the boxes around the indestructible
+ * blocks left of the old map and around the blocks of the new one, so it
+ * must be passed in after the next map is loaded. The caller decides
+ * whether a map change gets this event or a full draw_invalidate() (the
+ * game loop uses the latter when the event was dropped from a full queue).
+ *
+ * @param event Event taken from the event queue.
+ */
+void draw_event(const Event* event);
+
 /**
  * @brief Draws the paddle on the screen.
  *
@@ -21,12 +44,25 @@ void draw_paddle(Paddle* paddle);
  */
 void draw_ball(Ball* ball);
 
+/**
+ * @brief Draws every ball in play.
+ *
+ * @param balls Pointer to the ball pool.
+ */
+void draw_balls(const BallPool* balls);
+
+/**
+ * @brief Draws the falling power-up capsules.
+ */
+void draw_capsules(void);
+
 /**
  * @brief Draws a single block on the screen.
  *
- * @param block Pointer to the block structure containing its position and type.
+ * @param row Map row of the block.
+ * @param col Map column of the block.
  */
-void draw_block(Block* block);
+void draw_block(uint8_t row, uint8_t col);
 
 /**
  * @brief Draws all active blocks on the screen.
@@ -34,15 +70,21 @@ void draw_block(Block* block);
 void draw_blocks(void);
 
 /**
- * @brief Renders the entire game screen, including the paddle, ball, and blocks.
+ * @brief Renders the entire game screen, including the paddle, balls, and blocks.
+ *
+ * The frame is redrawn in the buffer, but only the areas marked by
+ * draw_event(), the old and new rectangles of moving sprites, and running
+ * block animations are sent to the display.
  *
  * @param paddle Pointer to the paddle structure.
- * @param ball Pointer to the ball structure.
+ * @param balls Pointer to the ball pool.
  */
-void draw_game(Paddle* paddle, Ball* ball);
+void draw_game(Paddle* paddle, const BallPool* balls);
 
 /**
- * @brief Displays the "Game Over" screen.
+ * @brief Draws the "Game Over" screen with the final score.
+ *
+ * Returns immediately; the screen manager decides how long it stays.
  */
 void game_over_display(void);
 
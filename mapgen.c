@@ -0,0 +1,110 @@
+#include "mapgen.h"
+#include "maps.h"
+#include <string.h>
+
+#define HALF_WIDTH ((MAP_WIDTH + 1) / 2) // Columns generated; the rest are their mirror images
+#define STEEL_ROWS ((VIEW_BLOCKS_BOTTOM + 1 - PLAYFIELD_TOP) / BLOCK_PITCH_Y) // Rows on screen with the view at the top
+
+// Block layouts of the left half of a map
+typedef enum {
+    PATTERN_FILL,       // Every cell
+    PATTERN_CHECKER,    // Alternate cells
+    PATTERN_STRIPES,    // Full rows between rows of every other cell
+    PATTERN_WEDGE,      // Rows widening towards the bottom
+    PATTERN_FRAME,      // Outer ring and centre column
+    PATTERN_COUNT
+} Pattern;
+
+static uint32_t rng_state;
+
+// xorshift32; the state must never be zero
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Whether a pattern puts a block in a cell of the left half
+static int pattern_cell(Pattern pattern, uint8_t row, uint8_t col, uint8_t rows) {
+    switch (pattern) {
+        case PATTERN_CHECKER:
+            return ((row + col) & 1) == 0;
+        case PATTERN_STRIPES:
+            return (row & 1) == 0 || (col & 1) == 0;
+        case PATTERN_WEDGE:
+            return col + 1 >= HALF_WIDTH - (row + 1) * HALF_WIDTH / rows;
+        case PATTERN_FRAME:
+            return row == 0 || row == rows - 1 || col == 0 || col == HALF_WIDTH - 1;
+        default:
+            return 1;
+    }
+}
+
+// Write the type nibble of a cell in the record, in the dense layout
+static void set_cell(uint8_t* cells, uint8_t index, uint8_t type) {
+    cells[index >> 1] |= (index & 1) ? (uint8_t)(type << 4) : type;
+}
+
+void mapgen_build(uint8_t* record, uint32_t seed, uint8_t level, uint8_t difficulty) {
+    if (difficulty > MAPGEN_MAX_DIFFICULTY) {
+        difficulty = MAPGEN_MAX_DIFFICULTY;
+    }
+
+    // Each level gets its own stream; a few rounds spread out neighbouring seeds
+    rng_state = seed ^ ((uint32_t)(level + 1) * 0x9E3779B9u);
+    if (rng_state == 0) {
+        rng_state = 0x2545F491u;
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        next_random();
+    }
+
+    uint8_t rows = (uint8_t)(3 + difficulty / 3);
+    if (rows > MAP_HEIGHT) rows = MAP_HEIGHT;
+    Pattern pattern = (Pattern)(next_random() % PATTERN_COUNT);
+    uint8_t density = (uint8_t)(160 + 6 * difficulty);              // Chance out of 256 that a pattern cell is used
+    uint8_t steel = (difficulty > 3) ? (uint8_t)(6 * (difficulty - 3)) : 0; // Chance of steel in a cell that may hold it
+    uint8_t hard = (uint8_t)(10 * difficulty);                      // Chance of stone or wood
+
+    memset(record, 0, MAPGEN_RECORD_SIZE);
+    record[0] = MAP_FORMAT_DENSE;
+    record[1] = (uint8_t)(MAP_WIDTH | (rows << 4));
+    uint8_t* cells = &record[2];
+    uint8_t destructible = 0;
+
+    for (uint8_t row = 0; row < rows; row++) {
+        uint8_t row_type = (uint8_t)(BLOCK_TYPE_2 + next_random() % (BLOCK_TYPE_6 - BLOCK_TYPE_2 + 1));
+
+        for (uint8_t col = 0; col < HALF_WIDTH; col++) {
+            uint8_t roll = (uint8_t)next_random();
+            if (!pattern_cell(pattern, row, col, rows) || (uint8_t)(next_random() >> 8) >= density) {
+                continue;
+            }
+
+            // Steel stays out of odd columns of the left half and their mirrors, and out of
+            // rows the view may scroll past: it never holds the view, so it must not end up
+            // near the paddle
+            uint8_t type = row_type;
+            if ((col & 1) == 0 && row < STEEL_ROWS && roll < steel) {
+                type = BLOCK_TYPE_STEEL;
+            } else if (roll < steel + hard) {
+                type = (roll & 1) ? BLOCK_TYPE_STONE : BLOCK_TYPE_WOOD;
+            }
+
+            set_cell(cells, (uint8_t)(row * MAP_WIDTH + col), type);
+            if (col != MAP_WIDTH - 1 - col) {
+                set_cell(cells, (uint8_t)(row * MAP_WIDTH + MAP_WIDTH - 1 - col), type);
+            }
+            if (type != BLOCK_TYPE_STEEL) {
+                destructible++;
+            }
+        }
+    }
+
+    // A map of nothing but steel could never be cleared
+    if (destructible == 0) {
+        set_cell(cells, 1, BLOCK_TYPE_2);
+        set_cell(cells, MAP_WIDTH - 2, BLOCK_TYPE_2);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef MAPGEN_H
+#define MAPGEN_H
+
+#include <stdint.h>
+#include "arkanoid.h"
+
+/**
+ * @brief Level generator parameters.
+ *
+ * Levels past the predefined maps are generated from the game seed, so a
+ * replay or a resumed game gets the same layouts back.
+ */
+#define MAPGEN_RECORD_SIZE (2 + BLOCK_CELLS_SIZE) ///< Size of a generated map record (dense, full width).
+#define MAPGEN_MAX_DIFFICULTY 15    ///< Hardest level the generator builds.
+#define MAPGEN_LEVELS_PER_STEP 3    ///< Generated levels played at each difficulty.
+
+/**
+ * @brief Generates a map record.
+ *
+ * Picks one of a few mirror-symmetric patterns and fills it with blocks.
+ * Higher difficulty gives more rows, denser layouts and more stone, wood
+ * and steel blocks. Every other column is kept free of steel, so a way up
+ * stays open and every map can be cleared, and steel only goes into the
+ * rows that fit on screen with the view at the top. Runs in a fixed number of steps
+ * and needs no memory beyond the record.
+ *
+ * @param record Filled with a MAP_FORMAT_DENSE record (MAPGEN_RECORD_SIZE bytes).
+ * @param seed Game seed; equal seeds and levels give equal maps.
+ * @param level Number of the generated level (0 = first after the predefined maps).
+ * @param difficulty Difficulty from 0 to MAPGEN_MAX_DIFFICULTY (larger values are clamped).
+ */
+void mapgen_build(uint8_t* record, uint32_t seed, uint8_t level, uint8_t difficulty);
+
+#endif // MAPGEN_H
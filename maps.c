@@ -145,13 +145,13 @@ const int maps[NUM_MAPS][MAP_HEIGHT][MAP_WIDTH] = {
         {2, 2, 2, 0, 2, 0, 2, 2, 2, 4},
         {1, 0, 1, 1, 1, 1, 1, 0, 1, 0},
         {3, 3, 0, 0, 0, 0, 0, 3, 3, 1},
-        {4, 0, 4, 4, 4, 4, 4, 0, 4, 0}
+        {7, 0, 6, 6, 6, 6, 6, 0, 7, 0}
     },
     {
         {1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
-        {0, 0, 1, 1, 1, 1, 1, 1, 0, 0},
-        {2, 2, 0, 0, 4, 4, 0, 0, 2, 2},
-        {1, 0, 1, 0, 1, 0, 1, 0, 1, 0}
+        {0, 0, 8, 8, 1, 1, 8, 8, 0, 0},
+        {2, 2, 0, 0, 6, 6, 0, 0, 2, 2},
+        {7, 0, 1, 0, 1, 0, 1, 0, 1, 7}
     }
 
 };
\ No newline at end of file
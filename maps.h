@@ -1,22 +1,61 @@
 #ifndef MAPS_H
 #define MAPS_H
 
+#include <stdint.h>
+
 /**
  * @brief Map dimensions and configuration.
+ *
+ * MAP_WIDTH x MAP_HEIGHT is the capacity of the block field; each map uses
+ * only the rows and columns it needs.
  */
-#define MAP_WIDTH 10      ///< Number of blocks in each row of the map.
-#define MAP_HEIGHT 4      ///< Number of blocks in each column of the map.
+#define MAP_WIDTH 10      ///< Maximum number of blocks in a row of a map (up to 15).
+#define MAP_HEIGHT 10     ///< Maximum number of block rows in a map (up to 15, taller maps scroll).
 #define NUM_MAPS 25       ///< Total number of predefined maps.
+#define NUM_LEVELS 255    ///< Levels in the sequence: the predefined maps, then generated ones.
+
+// A record stores the width and height of its map in one nibble each
+#if MAP_WIDTH > 15 || MAP_HEIGHT > 15
+#error "MAP_WIDTH and MAP_HEIGHT must fit in the 4-bit fields of a map record"
+#endif
+
+/**
+ * @brief Formats of a packed map record.
+ */
+#define MAP_FORMAT_DENSE 0   ///< Every cell of the map's bounding box, 4 bits each.
+#define MAP_FORMAT_SPARSE 1  ///< Block count, then a (cell index, type) byte pair per block.
+#define MAP_RECORD_DIMS(record) ((record)[1])                   ///< Packed width (low nibble) and height (high nibble).
+#define MAP_RECORD_WIDTH(record) (MAP_RECORD_DIMS(record) & 0x0F) ///< Width of a map record in blocks.
+#define MAP_RECORD_HEIGHT(record) (MAP_RECORD_DIMS(record) >> 4)  ///< Height of a map record in blocks.
 
 /**
  * @brief Array containing predefined maps.
  *
  * Each map is represented as a 2D array of integers where:
  * - 0 represents an empty space.
- * - Positive integers represent different block types.
+ * - Positive integers represent different block types (BlockType values;
+ *   6 is stone, 7 steel, 8 wood). A map needs at least one block that is
+ *   not steel to be cleared.
+ * Rows and cells left out of a map's initializer are empty.
  * 
  * Dimensions: [NUM_MAPS][MAP_HEIGHT][MAP_WIDTH].
  */
 extern const int maps[NUM_MAPS][MAP_HEIGHT][MAP_WIDTH];
 
+/**
+ * @brief Predefined maps packed into variable-size records.
+ *
+ * Generated from maps.c by tools/pack_maps.py (run as the pre-build step).
+ * A record starts with its format (MAP_FORMAT_*) and dimensions. Dense
+ * records store the cells of the map's bounding box row by row, two per byte
+ * with the lower index in the low nibble. Sparse records, used when they are
+ * smaller, list only the blocks; their cell indices are BLOCK_INDEX values.
+ */
+extern const uint8_t maps_data[];
+
+/**
+ * @brief Offset of each map's record in maps_data.
+ */
+extern const uint16_t maps_offset[NUM_MAPS];
+
 #endif // MAPS_H
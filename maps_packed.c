@@ -0,0 +1,61 @@
+// Generated by tools/pack_maps.py from maps.c - do not edit.
+#include "maps.h"
+
+const uint8_t maps_data[] = {
+    // Map 0: 10x4 dense
+    0x00, 0x4A, 0x11, 0x11, 0x11, 0x11, 0x11, 0x22, 0x22, 0x22, 0x22, 0x22, 0x33, 0x33, 0x33, 0x33, 0x33, 0x44, 0x44, 0x44, 0x44, 0x44,
+    // Map 1: 10x4 dense
+    0x00, 0x4A, 0x10, 0x11, 0x11, 0x11, 0x20, 0x00, 0x10, 0x11, 0x00, 0x03, 0x22, 0x02, 0x00, 0x22, 0x42, 0x34, 0x03, 0x33, 0x14, 0x01,
+    // Map 2: 10x4 dense
+    0x00, 0x4A, 0x22, 0x22, 0x22, 0x42, 0x23, 0x10, 0x31, 0x11, 0x00, 0x41, 0x00, 0x44, 0x04, 0x20, 0x03, 0x00, 0x00, 0x00, 0x00, 0x31,
+    // Map 3: 10x4 dense
+    0x00, 0x4A, 0x11, 0x01, 0x00, 0x11, 0x41, 0x10, 0x41, 0x11, 0x20, 0x04, 0x33, 0x20, 0x30, 0x03, 0x24, 0x22, 0x22, 0x22, 0x42, 0x33,
+    // Map 4: 10x4 dense
+    0x00, 0x4A, 0x34, 0x03, 0x33, 0x14, 0x20, 0x40, 0x04, 0x44, 0x20, 0x13, 0x22, 0x11, 0x21, 0x12, 0x42, 0x11, 0x00, 0x10, 0x41, 0x33,
+    // Map 5: 10x4 dense
+    0x00, 0x4A, 0x00, 0x21, 0x43, 0x23, 0x01, 0x01, 0x21, 0x23, 0x31, 0x14, 0x12, 0x10, 0x10, 0x10, 0x43, 0x23, 0x01, 0x21, 0x43, 0x23,
+    // Map 6: 10x4 dense
+    0x00, 0x4A, 0x33, 0x33, 0x33, 0x23, 0x31, 0x44, 0x44, 0x44, 0x14, 0x02, 0x11, 0x11, 0x11, 0x21, 0x13, 0x00, 0x00, 0x00, 0x40, 0x24,
+    // Map 7: 10x4 dense
+    0x00, 0x4A, 0x22, 0x22, 0x22, 0x02, 0x43, 0x31, 0x04, 0x34, 0x21, 0x34, 0x00, 0x11, 0x01, 0x30, 0x02, 0x44, 0x00, 0x40, 0x04, 0x11,
+    // Map 8: 10x4 dense
+    0x00, 0x4A, 0x00, 0x44, 0x44, 0x04, 0x03, 0x10, 0x11, 0x11, 0x00, 0x12, 0x32, 0x00, 0x00, 0x23, 0x44, 0x23, 0x11, 0x21, 0x43, 0x11,
+    // Map 9: 10x4 dense
+    0x00, 0x4A, 0x01, 0x32, 0x34, 0x42, 0x01, 0x12, 0x43, 0x40, 0x23, 0x03, 0x23, 0x04, 0x01, 0x34, 0x21, 0x34, 0x10, 0x12, 0x40, 0x04,
+    // Map 10: 10x4 dense
+    0x00, 0x4A, 0x33, 0x33, 0x33, 0x13, 0x44, 0x40, 0x44, 0x44, 0x30, 0x21, 0x22, 0x22, 0x22, 0x12, 0x04, 0x11, 0x11, 0x11, 0x31, 0x13,
+    // Map 11: 10x4 dense
+    0x00, 0x4A, 0x10, 0x11, 0x11, 0x11, 0x20, 0x03, 0x10, 0x11, 0x00, 0x03, 0x22, 0x02, 0x00, 0x22, 0x42, 0x34, 0x03, 0x33, 0x14, 0x01,
+    // Map 12: 10x4 dense
+    0x00, 0x4A, 0x33, 0x43, 0x44, 0x33, 0x23, 0x11, 0x14, 0x10, 0x14, 0x01, 0x32, 0x00, 0x02, 0x30, 0x42, 0x44, 0x44, 0x44, 0x44, 0x04,
+    // Map 13: 10x4 dense
+    0x00, 0x4A, 0x00, 0x30, 0x33, 0x00, 0x10, 0x44, 0x13, 0x12, 0x43, 0x24, 0x23, 0x01, 0x00, 0x21, 0x43, 0x12, 0x40, 0x44, 0x10, 0x31,
+    // Map 14: 10x4 dense
+    0x00, 0x4A, 0x12, 0x12, 0x12, 0x12, 0x02, 0x03, 0x04, 0x04, 0x04, 0x03, 0x14, 0x10, 0x10, 0x10, 0x04, 0x01, 0x00, 0x00, 0x00, 0x31,
+    // Map 15: 10x4 dense
+    0x00, 0x4A, 0x40, 0x04, 0x44, 0x40, 0x04, 0x03, 0x03, 0x03, 0x03, 0x33, 0x11, 0x11, 0x11, 0x11, 0x01, 0x44, 0x44, 0x44, 0x44, 0x24,
+    // Map 16: 10x4 dense
+    0x00, 0x4A, 0x32, 0x34, 0x32, 0x34, 0x32, 0x43, 0x41, 0x40, 0x41, 0x43, 0x14, 0x12, 0x10, 0x12, 0x14, 0x21, 0x43, 0x44, 0x23, 0x01,
+    // Map 17: 10x4 dense
+    0x00, 0x4A, 0x00, 0x11, 0x11, 0x11, 0x00, 0x34, 0x33, 0x30, 0x33, 0x23, 0x22, 0x02, 0x00, 0x22, 0x22, 0x10, 0x11, 0x10, 0x11, 0x01,
+    // Map 18: 10x4 dense
+    0x00, 0x4A, 0x44, 0x34, 0x12, 0x32, 0x44, 0x33, 0x23, 0x01, 0x21, 0x33, 0x22, 0x12, 0x40, 0x10, 0x22, 0x11, 0x01, 0x04, 0x04, 0x11,
+    // Map 19: 10x4 dense
+    0x00, 0x4A, 0x40, 0x40, 0x40, 0x40, 0x40, 0x04, 0x04, 0x04, 0x04, 0x04, 0x40, 0x40, 0x40, 0x40, 0x40, 0x04, 0x04, 0x04, 0x04, 0x04,
+    // Map 20: 10x4 dense
+    0x00, 0x4A, 0x33, 0x03, 0x00, 0x33, 0x33, 0x44, 0x40, 0x44, 0x40, 0x04, 0x00, 0x04, 0x04, 0x04, 0x40, 0x01, 0x01, 0x01, 0x01, 0x11,
+    // Map 21: 10x4 dense
+    0x00, 0x4A, 0x00, 0x30, 0x33, 0x00, 0x40, 0x11, 0x03, 0x00, 0x13, 0x11, 0x02, 0x24, 0x22, 0x04, 0x02, 0x43, 0x01, 0x00, 0x41, 0x43,
+    // Map 22: 10x4 dense
+    0x00, 0x4A, 0x01, 0x02, 0x03, 0x04, 0x01, 0x10, 0x20, 0x30, 0x40, 0x10, 0x03, 0x04, 0x01, 0x02, 0x03, 0x40, 0x10, 0x20, 0x30, 0x40,
+    // Map 23: 10x4 dense
+    0x00, 0x4A, 0x22, 0x02, 0x02, 0x22, 0x42, 0x01, 0x11, 0x11, 0x01, 0x01, 0x33, 0x00, 0x00, 0x30, 0x13, 0x07, 0x66, 0x66, 0x06, 0x07,
+    // Map 24: 10x4 dense
+    0x00, 0x4A, 0x11, 0x11, 0x11, 0x11, 0x11, 0x00, 0x88, 0x11, 0x88, 0x00, 0x22, 0x00, 0x66, 0x00, 0x22, 0x07, 0x01, 0x01, 0x01, 0x71,
+};
+
+const uint16_t maps_offset[NUM_MAPS] = {
+    0, 22, 44, 66, 88, 110, 132, 154, 176, 198,
+    220, 242, 264, 286, 308, 330, 352, 374, 396, 418,
+    440, 462, 484, 506, 528
+};
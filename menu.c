@@ -5,12 +5,17 @@
 #include "keyboard.h"
 #include "scores.h"
 #include "tsi.h"
+#include "screen.h"
+#include "game.h"
+#include "game_draw.h"
+#include "snapshot.h"
 #include <stdio.h>
 #include <string.h>
 
 //Menu options
-const char* menu_options[] = {"Start", "Score Board", "Options", "Nickname"};
-#define MENU_OPTIONS_COUNT 4 // Liczba opcji menu
+const char* menu_options[] = {"Start", "Score Board", "Options", "Nickname", "Resume", "Replay", "Demo"};
+#define MENU_OPTIONS_COUNT 7 // Liczba opcji menu
+#define MENU_VISIBLE 4       // Opcje mieszczce si na ekranie
 
 //Submenu "OLED Options" options
 const char* oled_options[] = {"Brigh", "Refresh R", "Mode", "Back"};
@@ -19,6 +24,7 @@ const char* oled_options[] = {"Brigh", "Refresh R", "Mode", "Back"};
 volatile uint32_t czas = 0;      // Timer in ms
 volatile uint8_t sekunda = 0;    // Licznik przerwa (do 10)
 volatile uint8_t sekunda_OK = 0; // "1" oznacza, e mina sekunda
+volatile uint32_t boot_menu_ms = 0; // Czas od startu SysTick do pierwszej klatki menu w ms (podgld w debuggerze)
 
 char user_nickname[6] = "GUEST"; // Domylny nick uytkownika
 
@@ -254,52 +260,146 @@ void show_oled_options(void) {
     }
 }
 
+// Ekran startowy: napis "OLED" do upywu czasu lub nacinicia klawisza
+static void splash_enter(void) {
+    ssd1306_display_startup_message();
+}
+
+// Wyczyszczenie ekranu przy wyjciu z ekranu czasowego
+static void timed_screen_exit(void) {
+    ssd1306_clear_screen(0x00);
+    ssd1306_refresh_gram();
+}
+
+// Wynik odtworzenia ostatniej gry
+static void replay_result_enter(void) {
+    ssd1306_clear_screen(0x00);
+    ssd1306_display_string(20, 24, (const uint8_t*)(replay_matched() ? "Replay OK" : "Replay DIFF"), 12, 1);
+    if (replay_truncated()) {
+        ssd1306_display_string(20, 40, (const uint8_t*)"(cut short)", 12, 1);
+    }
+    ssd1306_refresh_gram();
+}
+
+// Nagranie gry nie zmiecio si we Flash: odtworzenie koczy si wczeniej
+static void replay_cut_enter(void) {
+    ssd1306_clear_screen(0x00);
+    ssd1306_display_string(20, 16, (const uint8_t*)"Replay cut:", 12, 1);
+    ssd1306_display_string(20, 32, (const uint8_t*)"flash full", 12, 1);
+    ssd1306_refresh_gram();
+}
+
+static void menu_update(uint32_t now);
+
+static const Screen menu_screen = { NULL, menu_update, NULL, 0, NULL };
+static const Screen replay_screen = { replay_result_enter, NULL, timed_screen_exit, GAME_OVER_SCREEN_MS, &menu_screen };
+static const Screen splash_screen = { splash_enter, NULL, timed_screen_exit, SPLASH_SCREEN_MS, &menu_screen };
+static const Screen game_over_screen = { game_over_display, NULL, timed_screen_exit, GAME_OVER_SCREEN_MS, &menu_screen };
+static const Screen replay_cut_screen = { replay_cut_enter, NULL, timed_screen_exit, GAME_OVER_SCREEN_MS, &game_over_screen };
+
+static uint8_t selected_option = 0; // Wybrana opcja menu gwnego
+
+// Odtworzenie ostatniej nagranej gry
+static void menu_replay(void) {
+    if (replay_available()) {
+        start_game(user_nickname, REPLAY_PLAY);
+        screen_set(&replay_screen);
+    }
+}
+
+// Wznowienie gry zapisanej we Flash
+static void menu_resume(void) {
+    if (snapshot_available() && !resume_game(user_nickname)) {
+        screen_set(&game_over_screen);
+    }
+}
+
+// Tryb demo (autopilot), koczy go dowolny klawisz
+static void menu_demo(void) {
+    start_demo();
+    wait_for_key_release();
+}
+
+// Jeden przebieg menu gwnego
+static void menu_update(uint32_t now) {
+    if (boot_menu_ms == 0) {
+        boot_menu_ms = now; // Pomiar czasu uruchomienia, tylko raz
+    }
+    uint8_t first = (selected_option < MENU_VISIBLE) ? 0 : (uint8_t)(selected_option - MENU_VISIBLE + 1); // Lista przewija si za strzak
+
+    ssd1306_clear_screen(0x00);
+
+    for (uint8_t i = 0; i < MENU_VISIBLE; i++) {
+        ssd1306_display_string(20, i * 16, (const uint8_t*)menu_options[first + i], 12, 1);
+    }
+
+    draw_bitmap(0, (selected_option - first) * 16, block_bitmap_arrow, 8, 8);
+    ssd1306_refresh_gram();
+
+    uint8_t key = Keyboard_ReadKey();
+    if (key != 0xFF) {
+        debounce_delay();
+        switch (key_map[key / 3][key % 3][0]) {
+            case '1': 
+                selected_option = (selected_option + 1) % MENU_OPTIONS_COUNT;
+                wait_for_key_release();
+                break;
+            case '2': 
+                wait_for_key_release();
+                switch (selected_option) {
+                    case 0:
+                        if (!start_game(user_nickname, REPLAY_RECORD)) {
+                            // Zawieszona gra wraca prosto do menu
+                            screen_set(replay_truncated() ? &replay_cut_screen : &game_over_screen);
+                        }
+                        break;
+                    case 1:
+                        show_score_board();
+                        break;
+                    case 2:
+                        show_oled_options();
+                        break;
+                    case 3:
+                        enter_username();
+                        break;
+                    case 4:
+                        menu_resume();
+                        break;
+                    case 5:
+                        menu_replay();
+                        break;
+                    case 6:
+                        menu_demo();
+                        break;
+                }
+                break;
+            case '3': // Skrty klawiszowe pozycji Replay, Resume i Demo
+                wait_for_key_release();
+                menu_replay();
+                break;
+            case '4':
+                wait_for_key_release();
+                menu_resume();
+                break;
+            case '5':
+                wait_for_key_release();
+                menu_demo();
+                break;
+        }
+    }
+}
+
 // Wywietlanie gwnego menu
 void show_menu(void) {
     setup_systick();
     spi_init(SPI_MODE_0, 1000000, SPI_SIDE_MASTER);
     ssd1306_init();
-    ssd1306_clear_screen(0x00);
     Keyboard_Init();
 		TSI_Init();
-    uint8_t selected_option = 0;
 
-    while (1) {
-        ssd1306_clear_screen(0x00);
+    screen_set(&splash_screen);
 
-        for (uint8_t i = 0; i < MENU_OPTIONS_COUNT; i++) {
-            ssd1306_display_string(20, i * 16, (const uint8_t*)menu_options[i], 12, 1);
-        }
-
-        draw_bitmap(0, selected_option * 16, block_bitmap_arrow, 8, 8);
-        ssd1306_refresh_gram();
-
-        uint8_t key = Keyboard_ReadKey();
-        if (key != 0xFF) {
-            debounce_delay();
-            switch (key_map[key / 3][key % 3][0]) {
-                case '1': 
-                    selected_option = (selected_option + 1) % MENU_OPTIONS_COUNT;
-                    wait_for_key_release();
-                    break;
-                case '2': 
-                    wait_for_key_release();
-                    switch (selected_option) {
-                        case 0:
-														start_game(user_nickname);
-                            break;
-                        case 1:
-                            show_score_board();
-                            break;
-                        case 2:
-                            show_oled_options();
-                            break;
-                        case 3:
-                            enter_username();
-                            break;
-                    }
-                    break;
-            }
-        }
+    while (1) {
+        screen_update();
     }
 }
\ No newline at end of file
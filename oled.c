@@ -17,11 +17,23 @@
  */
 static uint8_t s_chDispalyBuffer[SSD1306_WIDTH][8];
 
+/**
+ * @brief Zakres brudnych kolumn dla kadej strony (lo > hi oznacza stron czyst)
+ */
+static uint8_t s_chDirtyLo[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static uint8_t s_chDirtyHi[8];
+
+/**
+ * @brief Grny wiersz okna widoku na ptnie oraz linia startowa ustawiona w wywietlaczu
+ */
+static uint8_t s_chViewTop = 0;
+static uint8_t s_chStartLine = 0;
+
 /**
  * @brief Wywietla wiadomo startow na ekranie OLED.
  * 
  * Wywietla duy napis "OLED" na rodku ekranu, a poniej mniejszy napis "LIB by ardys".
- * Po 5 sekundach ekran zostaje wyczyszczony.
+ * Nie czeka - czas wywietlania odmierza ekran startowy (splash_screen).
  */
  
 void ssd1306_display_startup_message(void) {
@@ -44,13 +56,6 @@ void ssd1306_display_startup_message(void) {
 
     // Odwieenie ekranu
     ssd1306_refresh_gram();
-
-    // Odczekanie 5 sekund
-    for (volatile uint32_t delay = 0; delay < 10000000; delay++);
-
-    // Wyczyszczenie ekranu
-    ssd1306_clear_screen(0x00);
-    ssd1306_refresh_gram(); // Odwieenie po wyczyszczeniu
 }
 
 /**
@@ -90,6 +95,34 @@ void ssd1306_display_off(void) {
 }
 
 
+/**
+ * @brief Przesya lini startow (0x40-0x7F), jeli okno widoku si przesuno.
+ * 
+ * Wysyana po danych, aby przewinicie i nowa tre pojawiy si razem.
+ */
+static void ssd1306_update_start_line(void) {
+    uint8_t line = s_chViewTop & (SSD1306_HEIGHT - 1);
+
+    if (line != s_chStartLine) {
+        ssd1306_write_byte(0x40 | line, SSD1306_CMD);
+        s_chStartLine = line;
+    }
+}
+
+/**
+ * @brief Ustawia okno widoku na wyszym wirtualnym ptnie.
+ * 
+ * Wiersz ptna y trafia do wiersza bufora y mod 64, a linia startowa
+ * wywietlacza jest ustawiana na top mod 64 przy nastpnym odwieeniu.
+ * Tre, ktra na ptnie stoi w miejscu, nie musi by wic wysyana
+ * ponownie po przewiniciu.
+ * 
+ * @param top Wiersz ptna wywietlany na grze ekranu.
+ */
+void ssd1306_set_view(uint8_t top) {
+    s_chViewTop = top;
+}
+
 /**
  * @brief Odwiea pami GRAM wywietlacza OLED.
  * 
@@ -100,10 +133,65 @@ void ssd1306_refresh_gram(void) {
         ssd1306_write_byte(0xB0 + i, SSD1306_CMD);
         ssd1306_write_byte(0x00, SSD1306_CMD);
         ssd1306_write_byte(0x10, SSD1306_CMD);
-        for (uint8_t j = 0; j < SSD1306_WIDTH+2; j++) {
+        for (uint8_t j = 0; j < SSD1306_WIDTH; j++) {
             ssd1306_write_byte(s_chDispalyBuffer[j][i], SSD1306_DAT);
         }
+        s_chDirtyLo[i] = 0xFF; // Cay ekran jest aktualny
+        s_chDirtyHi[i] = 0;
     }
+    ssd1306_update_start_line();
+}
+
+/**
+ * @brief Oznacza prostokt bufora jako zmieniony.
+ * 
+ * Cz prostokta poza oknem widoku jest pomijana.
+ * 
+ * @param x Pozycja X lewego grnego rogu.
+ * @param y Pozycja Y lewego grnego rogu (wiersz ptna).
+ * @param width Szeroko prostokta w pikselach.
+ * @param height Wysoko prostokta w pikselach.
+ */
+void ssd1306_mark_dirty(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    int16_t top = (int16_t)y - s_chViewTop; // Wiersze wzgldem okna widoku
+    int16_t bottom = top + height;
+
+    if (x >= SSD1306_WIDTH || width == 0 || bottom <= 0 || top >= SSD1306_HEIGHT) return;
+    if (top < 0) top = 0;
+    if (bottom > SSD1306_HEIGHT) bottom = SSD1306_HEIGHT;
+
+    uint8_t x_end = (x + width > SSD1306_WIDTH) ? SSD1306_WIDTH - 1 : x + width - 1;
+
+    // Wiersze okna le w buforze od linii startowej, wic strony mog si zawija
+    while (top < bottom) {
+        uint8_t row = (uint8_t)((top + s_chViewTop) & (SSD1306_HEIGHT - 1));
+        uint8_t page = row / 8;
+        if (x < s_chDirtyLo[page]) s_chDirtyLo[page] = x;
+        if (x_end > s_chDirtyHi[page]) s_chDirtyHi[page] = x_end;
+        top += 8 - (row & 7); // Pocztek nastpnej strony
+    }
+}
+
+/**
+ * @brief Przesya do wywietlacza tylko zmienione fragmenty bufora.
+ * 
+ * Dla kadej brudnej strony wysyany jest jedynie zakres kolumn oznaczony
+ * przez `ssd1306_mark_dirty`.
+ */
+void ssd1306_refresh_dirty(void) {
+    for (uint8_t i = 0; i < 8; i++) {
+        if (s_chDirtyLo[i] > s_chDirtyHi[i]) continue; // Strona bez zmian
+
+        ssd1306_write_byte(0xB0 + i, SSD1306_CMD);
+        ssd1306_write_byte(s_chDirtyLo[i] & 0x0F, SSD1306_CMD);        // Modsza cz adresu kolumny
+        ssd1306_write_byte(0x10 | (s_chDirtyLo[i] >> 4), SSD1306_CMD); // Starsza cz adresu kolumny
+        for (uint8_t j = s_chDirtyLo[i]; j <= s_chDirtyHi[i]; j++) {
+            ssd1306_write_byte(s_chDispalyBuffer[j][i], SSD1306_DAT);
+        }
+        s_chDirtyLo[i] = 0xFF;
+        s_chDirtyHi[i] = 0;
+    }
+    ssd1306_update_start_line();
 }
 
 /**
@@ -113,7 +201,7 @@ void ssd1306_refresh_gram(void) {
  */
 void ssd1306_clear_screen(uint8_t chFill) {
     for (uint8_t i = 0; i < 8; i++) {
-        for (uint8_t j = 0; j < SSD1306_WIDTH+2; j++) {
+        for (uint8_t j = 0; j < SSD1306_WIDTH; j++) {
             s_chDispalyBuffer[j][i] = chFill;
         }
     }
@@ -128,8 +216,9 @@ void ssd1306_clear_screen(uint8_t chFill) {
  * @param chPoint Stan punktu: 1 (wczony) lub 0 (wyczony).
  */
 void ssd1306_draw_point(uint8_t chXpos, uint8_t chYpos, uint8_t chPoint) {
-    if (chXpos >= SSD1306_WIDTH || chYpos >= SSD1306_HEIGHT) return;
+    if (chXpos >= SSD1306_WIDTH || (uint8_t)(chYpos - s_chViewTop) >= SSD1306_HEIGHT) return; // Poza oknem widoku
 
+    chYpos &= SSD1306_HEIGHT - 1; // Wiersz bufora
     uint8_t page = chYpos / 8;
     uint8_t bit_pos = chYpos % 8;
 
@@ -257,9 +346,8 @@ void ssd1306_init(void) {
     ssd1306_write_byte(0x8D, SSD1306_CMD);
     ssd1306_write_byte(0x14, SSD1306_CMD);
     ssd1306_write_byte(0xAF, SSD1306_CMD);
-
-    // Wywietlenie napisu startowego
-    ssd1306_display_startup_message();
+    s_chViewTop = 0; // Linia startowa 0x40 ustawiona powyej
+    s_chStartLine = 0;
 
     // Wyczyszczenie ekranu
     ssd1306_clear_screen(0x00);
@@ -319,7 +407,8 @@ void clear_bitmap(uint8_t x, uint8_t y) {
  * @return Stan piksela (1 - wczony, 0 - wyczony).
  */
 uint8_t ssd1306_get_pixel(uint8_t x, uint8_t y) {
-    if (x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT) return 0; // Poza zakresem
+    if (x >= SSD1306_WIDTH || (uint8_t)(y - s_chViewTop) >= SSD1306_HEIGHT) return 0; // Poza oknem widoku
+    y &= SSD1306_HEIGHT - 1;
     uint8_t page = y / 8;  // Okrela stron (okno 8-pikselowe)
     uint8_t bit_pos = y % 8;  // Okrela pozycj bitu w obrbie strony
 
@@ -333,7 +422,8 @@ uint8_t ssd1306_get_pixel(uint8_t x, uint8_t y) {
  * @param state Stan piksela (1 - wczony, 0 - wyczony).
  */
 void ssd1306_set_pixel(uint8_t x, uint8_t y, uint8_t state) {
-    if (x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT) return;  // Poza zakresem
+    if (x >= SSD1306_WIDTH || (uint8_t)(y - s_chViewTop) >= SSD1306_HEIGHT) return;  // Poza oknem widoku
+    y &= SSD1306_HEIGHT - 1;
 
     uint8_t page = y / 8;  // Okrela stron
     uint8_t bit_pos = y % 8;  // Okrela pozycj bitu w obrbie strony
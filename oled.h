@@ -16,6 +16,13 @@
  */
 void ssd1306_init(void);
 
+/**
+ * @brief Draws the startup message and sends it to the display.
+ *
+ * Returns immediately; how long the message stays is up to the caller.
+ */
+void ssd1306_display_startup_message(void);
+
 /**
  * @brief Turns the OLED display on.
  */
@@ -31,6 +38,36 @@ void ssd1306_display_off(void);
  */
 void ssd1306_refresh_gram(void);
 
+/**
+ * @brief Marks a rectangle of the screen buffer as changed.
+ *
+ * @param x X-coordinate of the top-left corner.
+ * @param y Y-coordinate of the top-left corner.
+ * @param width Width of the rectangle in pixels.
+ * @param height Height of the rectangle in pixels.
+ */
+void ssd1306_mark_dirty(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+
+/**
+ * @brief Sends only the changed parts of the screen buffer to the display.
+ *
+ * Each page uploads just the column span covered by ssd1306_mark_dirty()
+ * since the last refresh.
+ */
+void ssd1306_refresh_dirty(void);
+
+/**
+ * @brief Places the screen as a 64-row window on a taller virtual canvas.
+ *
+ * Drawing and ssd1306_mark_dirty() then take canvas rows and clip to
+ * [top, top + 64). Canvas row y lives in buffer row y mod 64 and the next
+ * refresh moves the display start line (0x40-0x7F) to top mod 64, so a
+ * scroll re-uploads only what moved on the canvas or was newly exposed.
+ *
+ * @param top Canvas row shown at the top of the screen (0 for a plain screen).
+ */
+void ssd1306_set_view(uint8_t top);
+
 /**
  * @brief Sends a byte of data or a command to the OLED display.
  *
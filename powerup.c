@@ -0,0 +1,160 @@
+#include "powerup.h"
+#include "event_queue.h"
+#ifdef ARKANOID_HOST
+#include <string.h>
+#endif
+
+// Global variables
+Capsule capsules[MAX_CAPSULES];
+uint8_t capsule_active = 0;
+
+static uint8_t drop_counter = 0;      // Blocks destroyed since the last drop
+static uint8_t next_type = 0;         // Power-up carried by the next capsule
+static uint8_t fall_ticks = 0;        // Ticks since the capsules last moved
+static uint8_t expanding = 0;         // Paddle expansion is running
+static uint32_t expand_end = 0;       // Time the expansion runs out, in ms
+static uint8_t multiball_pending = 0; // Multiball caught while serving, split at the launch
+
+// Reset the power-up state
+void powerup_init(void) {
+    capsule_active = 0;
+    drop_counter = 0;
+    next_type = 0;
+    fall_ticks = 0;
+    expanding = 0;
+    multiball_pending = 0;
+}
+
+// Drop a capsule from every n-th destroyed block
+void powerup_block_destroyed(uint8_t index) {
+    if (++drop_counter < POWERUP_DROP_EVERY) {
+        return;
+    }
+    drop_counter = 0;
+
+    for (uint8_t i = 0; i < MAX_CAPSULES; i++) {
+        if (!(capsule_active & (1u << i))) {
+            capsules[i].x = BLOCK_X(index % MAP_WIDTH) + (BLOCK_WIDTH - CAPSULE_WIDTH) / 2;
+            capsules[i].y = BLOCK_Y(index / MAP_WIDTH);
+            capsules[i].type = next_type;
+            capsule_active |= (uint8_t)(1u << i);
+            next_type = (uint8_t)((next_type + 1) % POWERUP_COUNT);
+            return;
+        }
+    }
+}
+
+// Set the paddle width, keeping it centered and on screen
+static void set_paddle_width(Paddle* paddle, uint8_t width) {
+    int x = paddle->x + paddle->width / 2 - width / 2;
+
+    if (x < 0) x = 0;
+    if (x > SCREEN_WIDTH - width) x = SCREEN_WIDTH - width;
+    paddle->x = (uint8_t)x;
+    paddle->width = width;
+}
+
+// Split the first ball in play into three: the ball and its mirror images across the vertical and
+// through the center. Ball velocities are never zero on either axis, so all three fly apart.
+static void spawn_multiball(BallPool* balls) {
+    if (balls->active == 0) {
+        return;
+    }
+
+    uint8_t i = (uint8_t)__builtin_ctz(balls->active);
+    Ball ball = { balls->x[i], balls->y[i], balls->dx[i], balls->dy[i], balls->fx[i], balls->fy[i] };
+
+    ball.dx = (int8_t)-ball.dx;
+    ball_pool_spawn(balls, &ball);
+    ball.dy = (int8_t)-ball.dy; // Heads up if the first two head down, and the other way round
+    ball_pool_spawn(balls, &ball);
+}
+
+// Apply a caught power-up
+static void apply_powerup(uint8_t type, Paddle* paddle, BallPool* balls, uint32_t now) {
+    switch (type) {
+        case POWERUP_EXPAND:
+            set_paddle_width(paddle, PADDLE_WIDTH_EXPANDED);
+            expanding = 1;
+            expand_end = now + POWERUP_EXPAND_MS; // Catching another one restarts the timer
+            break;
+        case POWERUP_EXTRA_LIFE:
+            if (lives < POWERUP_MAX_LIVES) {
+                lives++;
+                event_post(EVENT_LIFE_GAINED, (uint8_t)lives);
+            }
+            break;
+        case POWERUP_MULTIBALL:
+            if (game_state == GAME_STATE_SERVE) {
+                multiball_pending = 1; // The serve rebuilds the pool every tick
+            } else {
+                spawn_multiball(balls);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Move capsules, catch them with the paddle and run effect timers
+void powerup_update(Paddle* paddle, BallPool* balls, uint32_t now) {
+    uint8_t fall = 0;
+
+    if (++fall_ticks >= CAPSULE_FALL_PERIOD) {
+        fall_ticks = 0;
+        fall = 1;
+    }
+
+    for (uint8_t bits = capsule_active; bits; bits &= bits - 1) {
+        uint8_t i = (uint8_t)__builtin_ctz(bits);
+        Capsule* capsule = &capsules[i];
+
+        capsule->y += fall;
+
+        if (capsule->y + CAPSULE_HEIGHT >= paddle->y &&
+            capsule->y <= paddle->y + PADDLE_HEIGHT &&
+            capsule->x + CAPSULE_WIDTH > paddle->x &&
+            capsule->x < paddle->x + paddle->width) {
+            apply_powerup(capsule->type, paddle, balls, now); // Caught
+            capsule_active &= (uint8_t)~(1u << i);
+        } else if (capsule->y >= view_top + SCREEN_HEIGHT) {
+            capsule_active &= (uint8_t)~(1u << i); // Missed
+        }
+    }
+
+    if (multiball_pending && game_state == GAME_STATE_PLAY) {
+        multiball_pending = 0;
+        spawn_multiball(balls);
+    }
+
+    if (expanding && (int32_t)(now - expand_end) >= 0) {
+        expanding = 0;
+        set_paddle_width(paddle, PADDLE_WIDTH);
+    }
+}
+
+#ifdef ARKANOID_HOST
+// Save the power-up state of the current game
+void powerup_context_save(PowerupContext* context) {
+    memcpy(context->capsules, capsules, sizeof(capsules));
+    context->active = capsule_active;
+    context->drop_counter = drop_counter;
+    context->next_type = next_type;
+    context->fall_ticks = fall_ticks;
+    context->expanding = expanding;
+    context->expand_end = expand_end;
+    context->multiball_pending = multiball_pending;
+}
+
+// Switch to saved power-up state
+void powerup_context_load(const PowerupContext* context) {
+    memcpy(capsules, context->capsules, sizeof(capsules));
+    capsule_active = context->active;
+    drop_counter = context->drop_counter;
+    next_type = context->next_type;
+    fall_ticks = context->fall_ticks;
+    expanding = context->expanding;
+    expand_end = context->expand_end;
+    multiball_pending = context->multiball_pending;
+}
+#endif
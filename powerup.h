@@ -0,0 +1,106 @@
+#ifndef POWERUP_H
+#define POWERUP_H
+
+#include <stdint.h>
+#include "arkanoid.h"
+
+/**
+ * @brief Power-up pool and timing parameters.
+ *
+ * All capsules live in a static pool, so RAM use is fixed at compile time:
+ * MAX_CAPSULES * sizeof(Capsule) plus a few bytes of state.
+ */
+#ifndef MAX_CAPSULES
+#define MAX_CAPSULES 4              ///< Maximum number of capsules falling at once (up to 8).
+#endif
+#define CAPSULE_WIDTH 8             ///< Capsule width in pixels.
+#define CAPSULE_HEIGHT 4            ///< Capsule height in pixels.
+#define CAPSULE_FALL_PERIOD 2       ///< Ticks per pixel of capsule fall.
+#define POWERUP_DROP_EVERY 6        ///< A capsule drops from every n-th destroyed block.
+#define POWERUP_EXPAND_MS 10000     ///< Duration of the paddle expansion in ms.
+#define PADDLE_WIDTH_EXPANDED 30    ///< Paddle width while expanded in pixels.
+#define POWERUP_MAX_LIVES 9         ///< Extra lives stop at the largest value the HUD can show.
+
+/**
+ * @brief Types of power-ups.
+ */
+typedef enum {
+    POWERUP_EXPAND,                 ///< Wider paddle for a limited time.
+    POWERUP_EXTRA_LIFE,             ///< One extra life.
+    POWERUP_MULTIBALL,              ///< Two extra balls (caught while serving, they split off at the launch).
+    POWERUP_COUNT                   ///< Number of power-up types.
+} PowerUpType;
+
+/**
+ * @brief Structure representing a falling power-up capsule.
+ */
+typedef struct {
+    uint8_t x, y;                   ///< Position of the capsule.
+    uint8_t type;                   ///< Power-up carried by the capsule (PowerUpType).
+} Capsule;
+
+/**
+ * @brief Global variables.
+ */
+extern Capsule capsules[MAX_CAPSULES]; ///< Capsule pool.
+extern uint8_t capsule_active;         ///< Bit n is set while capsule n is falling.
+
+/**
+ * @brief Clears all capsules and running effects.
+ */
+void powerup_init(void);
+
+/**
+ * @brief Notifies the power-up system that a block was destroyed.
+ *
+ * Every POWERUP_DROP_EVERY-th block drops a capsule from a free pool slot;
+ * the drop is skipped when the pool is full.
+ *
+ * @param index Cell index of the destroyed block.
+ */
+void powerup_block_destroyed(uint8_t index);
+
+/**
+ * @brief Advances capsules by one tick and runs the effect timers.
+ *
+ * Moves the capsules down, applies the ones caught by the paddle and
+ * restores the paddle once the expansion timer runs out. Capsules move per
+ * tick like the balls; effect timers run in ms, like the serve delay.
+ *
+ * @param paddle Pointer to the paddle structure.
+ * @param balls Pointer to the ball pool (used by multiball).
+ * @param now Current time in milliseconds.
+ */
+void powerup_update(Paddle* paddle, BallPool* balls, uint32_t now);
+
+#ifdef ARKANOID_HOST
+/**
+ * @brief Power-up state of one game, for host tools that step many games in one process.
+ */
+typedef struct {
+    Capsule capsules[MAX_CAPSULES]; ///< Capsule pool.
+    uint8_t active;                 ///< Bit n is set while capsule n is falling.
+    uint8_t drop_counter;           ///< Blocks destroyed since the last drop.
+    uint8_t next_type;              ///< Power-up carried by the next capsule.
+    uint8_t fall_ticks;             ///< Ticks since the capsules last moved.
+    uint8_t expanding;              ///< Paddle expansion is running.
+    uint32_t expand_end;            ///< Time the expansion runs out, in ms.
+    uint8_t multiball_pending;      ///< Multiball caught while serving.
+} PowerupContext;
+
+/**
+ * @brief Copies the power-up state of the current game into a context.
+ *
+ * @param context Filled with the state.
+ */
+void powerup_context_save(PowerupContext* context);
+
+/**
+ * @brief Makes saved power-up state the current one.
+ *
+ * @param context State saved by powerup_context_save().
+ */
+void powerup_context_load(const PowerupContext* context);
+#endif
+
+#endif // POWERUP_H
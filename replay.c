@@ -0,0 +1,291 @@
+#include "replay.h"
+#include "powerup.h"
+#include "snapshot.h"
+#include <string.h>
+
+// Field flags of a tick record
+#define FIELD_TOUCH 0x01
+#define FIELD_KEY   0x02
+#define FIELD_BITS  2
+
+// Largest tick record: run/flags varint, slider delta, key byte
+#define MAX_RECORD_SIZE (5 + 2 + 1)
+
+#define STREAM_SIZE (REPLAY_REGION_SIZE - REPLAY_HEADER_SIZE)
+
+#if REPLAY_REGION % FLASH_SECTOR_SIZE != 0 || REPLAY_REGION + REPLAY_REGION_SIZE > SNAPSHOT_SECTOR
+#error "The replay region must be sector aligned and end below the snapshot sector"
+#endif
+#if STREAM_SIZE > 0xFFFF || REPLAY_HEADER_SIZE % 4 != 0 || REPLAY_CHUNK_SIZE % 4 != 0
+#error "Replay region layout does not fit the header fields or flash words"
+#endif
+_Static_assert(sizeof(ReplayHeader) == REPLAY_HEADER_SIZE, "ReplayHeader is written to flash as is");
+
+#ifdef ARKANOID_HOST
+// The host has no flash: the region is a RAM image with the same layout
+static uint32_t region_words[REPLAY_REGION_SIZE / 4]; // Word aligned like a flash sector
+#define region ((uint8_t*)region_words)
+#define REGION_DATA ((const uint8_t*)region_words)
+
+static int region_erase(void) {
+    memset(region, 0xFF, REPLAY_REGION_SIZE);
+    return 1;
+}
+
+static int region_write(uint32_t offset, const uint8_t* data, uint32_t size) {
+    memcpy(&region[offset], data, size);
+    return 1;
+}
+
+const uint8_t* replay_image(void) {
+    return region;
+}
+#else
+#define REGION_DATA ((const uint8_t*)(uintptr_t)REPLAY_REGION) // Read in place, flash is memory mapped
+
+static int region_erase(void) {
+    for (uint32_t i = 0; i < REPLAY_SECTORS; i++) {
+        if (!Flash_EraseSector(REPLAY_REGION + i * FLASH_SECTOR_SIZE)) return 0;
+    }
+    return 1;
+}
+
+static int region_write(uint32_t offset, const uint8_t* data, uint32_t size) {
+    return Flash_Write(REPLAY_REGION + offset, data, size);
+}
+#endif
+
+#define STORED_HEADER ((const ReplayHeader*)(const void*)REGION_DATA)
+#define STREAM (REGION_DATA + REPLAY_HEADER_SIZE)
+
+static ReplayHeader header;
+static uint8_t chunk[REPLAY_CHUNK_SIZE]; // Recording: stream bytes not yet in flash
+static ReplayMode mode = REPLAY_OFF;
+static uint8_t failed = 0;      // Recording: a flash operation failed, the recording is dropped
+static uint8_t matched = 0;     // Result of the last playback
+
+// Coder state: last input, position in the stream and pending run of unchanged ticks
+static uint8_t last_touch;
+static uint8_t last_key;
+static uint16_t pos;
+static uint16_t run;
+static uint16_t ticks;
+static uint8_t pending;         // Playback: a decoded record is waiting for its run to end
+static uint8_t pending_flags;
+static int32_t pending_touch;
+static uint8_t pending_key;
+
+// Append a byte; full chunks go to flash
+static void put_byte(uint8_t value) {
+    chunk[pos % REPLAY_CHUNK_SIZE] = value;
+    pos++;
+    if (pos % REPLAY_CHUNK_SIZE == 0 && !failed) {
+        failed = !region_write(REPLAY_HEADER_SIZE + pos - REPLAY_CHUNK_SIZE, chunk, REPLAY_CHUNK_SIZE);
+    }
+}
+
+static void put_varint(uint32_t value) {
+    while (value >= 0x80) {
+        put_byte((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    put_byte((uint8_t)value);
+}
+
+static uint32_t get_varint(void) {
+    uint32_t value = 0;
+    uint8_t shift = 0;
+    uint8_t byte;
+
+    do {
+        byte = STREAM[pos++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while ((byte & 0x80) && shift < 35);
+    return value;
+}
+
+// Signed deltas are zigzag-encoded so small steps either way stay one byte
+static uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Close the current run of unchanged ticks with a record that changes nothing
+static void flush_run(void) {
+    if (run > 0) {
+        put_varint((uint32_t)(run - 1) << FIELD_BITS);
+        run = 0;
+    }
+}
+
+ReplayMode replay_mode(void) {
+    return mode;
+}
+
+void replay_start(ReplayMode new_mode) {
+    mode = new_mode;
+    last_touch = 0;
+    last_key = 0xFF;
+    pos = 0;
+    run = 0;
+    ticks = 0;
+    pending = 0;
+
+    if (mode == REPLAY_RECORD) {
+        failed = !region_erase();
+        memset(&header, 0, sizeof(header));
+        header.version = REPLAY_VERSION;
+        header.map = (uint8_t)(current_map - 1); // game_init() already loaded the first map
+        header.seed = game_seed;
+    } else if (mode == REPLAY_PLAY) {
+        header = *STORED_HEADER;
+        game_seed = header.seed;
+        if (header.map != 0) {
+            current_map = header.map;
+            load_next_map();
+        }
+    }
+}
+
+int replay_input(uint8_t* touch_pos, uint8_t* key) {
+    if (mode == REPLAY_RECORD) {
+        uint8_t flags = 0;
+        int move = (int)*touch_pos - last_touch;
+
+        // Stop recording before the region or the tick counter overflows
+        if (pos + MAX_RECORD_SIZE + 5 > STREAM_SIZE || ticks == 0xFFFF) {
+            header.flags |= REPLAY_FLAG_TRUNCATED;
+            return 0;
+        }
+
+        // Slider noise would cost a record on almost every tick. Touching or letting go is always recorded.
+        if (*touch_pos != 0 && last_touch != 0 && move > -REPLAY_TOUCH_DEADBAND && move < REPLAY_TOUCH_DEADBAND) {
+            *touch_pos = last_touch;
+        }
+        if (*touch_pos != last_touch) flags |= FIELD_TOUCH;
+        if (*key != last_key) flags |= FIELD_KEY;
+
+        if (flags == 0) {
+            run++;
+        } else {
+            put_varint(((uint32_t)run << FIELD_BITS) | flags);
+            if (flags & FIELD_TOUCH) put_varint(zigzag((int32_t)*touch_pos - last_touch));
+            if (flags & FIELD_KEY) put_byte(*key);
+            run = 0;
+            last_touch = *touch_pos;
+            last_key = *key;
+        }
+        ticks++;
+        return 1;
+    }
+
+    if (mode != REPLAY_PLAY) {
+        return 1;
+    }
+    if (ticks == header.ticks) {
+        return 0; // End of the recording
+    }
+
+    if (!pending) {
+        uint32_t record = get_varint();
+
+        run = (uint16_t)(record >> FIELD_BITS);
+        pending_flags = (uint8_t)(record & ((1u << FIELD_BITS) - 1));
+        if (pending_flags & FIELD_TOUCH) pending_touch = unzigzag(get_varint());
+        if (pending_flags & FIELD_KEY) pending_key = STREAM[pos++];
+        pending = 1;
+    }
+
+    if (run > 0) {
+        run--; // Same input as the previous tick
+    } else {
+        if (pending_flags & FIELD_TOUCH) last_touch = (uint8_t)(last_touch + pending_touch);
+        if (pending_flags & FIELD_KEY) last_key = pending_key;
+        pending = 0;
+    }
+
+    *touch_pos = last_touch;
+    *key = last_key;
+    ticks++;
+    return 1;
+}
+
+void replay_finish(uint32_t hash) {
+    if (mode == REPLAY_RECORD) {
+        uint16_t tail;
+
+        flush_run();
+        header.ticks = ticks;
+        header.size = pos;
+        header.hash = hash;
+
+        // The partial chunk, padded to whole flash words, then the header that makes the recording valid
+        tail = pos % REPLAY_CHUNK_SIZE;
+        if (tail != 0 && !failed) {
+            memset(&chunk[tail], 0xFF, (size_t)((-tail) & 3));
+            failed = !region_write(REPLAY_HEADER_SIZE + pos - tail, chunk, (uint32_t)((tail + 3) & ~3));
+        }
+        if (!failed) {
+            region_write(0, (const uint8_t*)&header, sizeof(header));
+        }
+    } else if (mode == REPLAY_PLAY) {
+        matched = (ticks == header.ticks && hash == header.hash);
+    }
+    mode = REPLAY_OFF;
+}
+
+int replay_available(void) {
+    return STORED_HEADER->version == REPLAY_VERSION;
+}
+
+int replay_truncated(void) {
+    return replay_available() && (STORED_HEADER->flags & REPLAY_FLAG_TRUNCATED) != 0;
+}
+
+int replay_matched(void) {
+    return matched;
+}
+
+// FNV-1a over the bytes of a value, least significant first
+static uint32_t hash_bytes(uint32_t hash, uint32_t value, uint8_t size) {
+    for (uint8_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)(value >> (8 * i));
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t replay_state_hash(const Paddle* paddle, const BallPool* balls) {
+    uint32_t hash = 2166136261u;
+
+    for (uint8_t i = 0; i < BLOCK_CELLS_SIZE; i++) {
+        hash = hash_bytes(hash, block_cells[i], 1);
+        hash = hash_bytes(hash, block_damage[i], 1);
+    }
+    hash = hash_bytes(hash, blocks_remaining, 1);
+    hash = hash_bytes(hash, (uint32_t)current_score, 4);
+    hash = hash_bytes(hash, (uint32_t)current_map, 4);
+    hash = hash_bytes(hash, (uint32_t)lives, 4);
+    hash = hash_bytes(hash, (uint32_t)game_state, 1);
+    hash = hash_bytes(hash, view_top, 1);
+    hash = hash_bytes(hash, paddle->x | (paddle->y << 8) | ((uint32_t)paddle->width << 16), 3);
+
+    // Only slots in play: free slots may hold stale data
+    hash = hash_bytes(hash, balls->active, 2);
+    for (uint16_t bits = balls->active; bits; bits &= bits - 1) {
+        uint8_t i = (uint8_t)__builtin_ctz(bits);
+        hash = hash_bytes(hash, balls->x[i] | (balls->y[i] << 8) | ((uint32_t)(uint8_t)balls->dx[i] << 16) | ((uint32_t)(uint8_t)balls->dy[i] << 24), 4);
+        hash = hash_bytes(hash, balls->fx[i] | (balls->fy[i] << 8), 2);
+    }
+
+    hash = hash_bytes(hash, capsule_active, 1);
+    for (uint8_t bits = capsule_active; bits; bits &= bits - 1) {
+        const Capsule* capsule = &capsules[__builtin_ctz(bits)];
+        hash = hash_bytes(hash, capsule->x | (capsule->y << 8) | ((uint32_t)capsule->type << 16), 3);
+    }
+    return hash;
+}
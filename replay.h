@@ -0,0 +1,151 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include "arkanoid.h"
+#include "flash.h"
+
+/**
+ * @brief Replay storage parameters.
+ *
+ * Recorded and replayed games run on a game clock that advances
+ * REPLAY_TICK_MS per tick instead of millis(), so the stream holds no time:
+ * each tick stores only the slider value and the key code. Only fields that
+ * changed are written, as zigzag varint deltas behind a varint header that
+ * also counts the unchanged ticks before them. While recording, slider moves
+ * smaller than REPLAY_TOUCH_DEADBAND keep the last value (the game gets the
+ * recorded value too), so slider noise costs nothing and a moving slider
+ * about 2 bytes per tick.
+ *
+ * The stream goes to flash REPLAY_CHUNK_SIZE bytes at a time, into the
+ * sectors below the snapshot sector; the header is written last, at the
+ * start of the region. A recording survives a power cycle. The host build
+ * keeps the region in RAM with the same layout.
+ */
+#define REPLAY_TICK_MS 16           ///< Game time per tick of a recorded game in ms (one frame of the game loop).
+#define REPLAY_TOUCH_DEADBAND 2     ///< Smallest recorded slider move.
+#define REPLAY_REGION 0x6C00        ///< Flash address of the replay region (sector aligned).
+#define REPLAY_SECTORS 4            ///< Flash sectors of the replay region, up to the snapshot sector.
+#define REPLAY_REGION_SIZE (REPLAY_SECTORS * FLASH_SECTOR_SIZE) ///< Size of the replay region in bytes.
+#define REPLAY_HEADER_SIZE 16       ///< Bytes at the start of the region reserved for the header.
+#define REPLAY_CHUNK_SIZE 32        ///< Stream bytes buffered in RAM per flash write (multiple of 4).
+#define REPLAY_VERSION 2            ///< Format version stored in the replay header.
+
+/**
+ * @brief Replay modes of a game.
+ */
+typedef enum {
+    REPLAY_OFF,                     ///< Live input, nothing recorded.
+    REPLAY_RECORD,                  ///< Live input, recorded into the replay region.
+    REPLAY_PLAY                     ///< Input fed back from the replay region.
+} ReplayMode;
+
+#define REPLAY_FLAG_TRUNCATED 0x01  ///< The region filled up before the game ended.
+
+/**
+ * @brief Structure describing a recorded game (REPLAY_HEADER_SIZE bytes, same layout on host and device).
+ */
+typedef struct {
+    uint8_t version;                ///< Format version (REPLAY_VERSION).
+    uint8_t map;                    ///< Index of the first map of the game.
+    uint16_t ticks;                 ///< Number of recorded ticks.
+    uint16_t size;                  ///< Number of used bytes in the input stream.
+    uint8_t flags;                  ///< REPLAY_FLAG_* bits.
+    uint8_t reserved;               ///< Padding, 0.
+    uint32_t seed;                  ///< Game seed at the start of the recording.
+    uint32_t hash;                  ///< State hash after the last recorded tick.
+} ReplayHeader;
+
+/**
+ * @brief Returns the current replay mode.
+ *
+ * @return Mode set by the last replay_start().
+ */
+ReplayMode replay_mode(void);
+
+/**
+ * @brief Starts recording or playing back a game.
+ *
+ * Must be called right after game_init(). Recording erases the replay
+ * region, and with it the previous recording. Playback restores the seed
+ * and first map of the recording and requires replay_available().
+ *
+ * @param mode Replay mode of the game.
+ */
+void replay_start(ReplayMode mode);
+
+/**
+ * @brief Records or replaces the input of one tick.
+ *
+ * While recording the inputs are appended to the stream; a slider move
+ * within the deadband is replaced with the last recorded value. During
+ * playback the inputs are overwritten with the recorded ones.
+ *
+ * When the region is full or playback has run out of recorded ticks, the
+ * tick is not handled and 0 is returned: the caller must then end the
+ * replay with replay_finish() before simulating the tick. A game whose
+ * recording filled up goes on with live input, and the recording is
+ * marked as truncated.
+ *
+ * @param touch_pos Slider value of the tick.
+ * @param key Key code of the tick (0xFF if none).
+ * @return 0 if the replay ended at this tick, 1 otherwise.
+ */
+int replay_input(uint8_t* touch_pos, uint8_t* key);
+
+/**
+ * @brief Ends the recording or playback.
+ *
+ * A recording writes the rest of the stream and the header with the final
+ * state hash. Playback compares it with the recorded one (see
+ * replay_matched()).
+ *
+ * @param hash State hash after the last tick (see replay_state_hash()).
+ */
+void replay_finish(uint32_t hash);
+
+/**
+ * @brief Checks whether a finished recording can be played back.
+ *
+ * @return 1 if a recording is available, 0 otherwise.
+ */
+int replay_available(void);
+
+/**
+ * @brief Checks whether the stored recording stops before the end of its game.
+ *
+ * @return 1 if the replay region filled up while recording, 0 otherwise.
+ */
+int replay_truncated(void);
+
+/**
+ * @brief Reports the result of the last playback.
+ *
+ * @return 1 if playback ended on the recorded state hash, 0 otherwise.
+ */
+int replay_matched(void);
+
+/**
+ * @brief Hashes the simulation state.
+ *
+ * Covers the blocks, score, lives, map, game state, paddle, balls in play
+ * and falling capsules. Values are hashed byte by byte in a fixed order,
+ * so host and device builds produce the same hash for the same state.
+ *
+ * @param paddle Pointer to the paddle structure.
+ * @param balls Pointer to the ball pool.
+ * @return 32-bit FNV-1a hash of the state.
+ */
+uint32_t replay_state_hash(const Paddle* paddle, const BallPool* balls);
+
+#ifdef ARKANOID_HOST
+/**
+ * @brief Returns the RAM image of the replay region, REPLAY_REGION_SIZE bytes.
+ *
+ * Written to REPLAY_REGION of a board, it plays back there like a recording
+ * made on the device.
+ */
+const uint8_t* replay_image(void);
+#endif
+
+#endif // REPLAY_H
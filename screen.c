@@ -0,0 +1,50 @@
+#include "screen.h"
+#include "menu.h"
+#include "keyboard.h"
+#include <stddef.h>
+
+static const Screen* current_screen = NULL;
+static uint32_t screen_start = 0; // Time the current screen was entered, in ms
+static uint8_t skip_armed = 0;    // Set once all keys were released on a timed screen
+
+// Switch screens, running the exit and enter hooks
+void screen_set(const Screen* screen) {
+    if (current_screen != NULL && current_screen->exit != NULL) {
+        current_screen->exit();
+    }
+
+    current_screen = screen;
+    screen_start = millis();
+    skip_armed = 0;
+
+    if (screen->enter != NULL) {
+        screen->enter();
+    }
+}
+
+// Run the current screen and end it when its time is up or a key skips it
+void screen_update(void) {
+    const Screen* screen = current_screen;
+    uint32_t now = millis();
+
+    if (screen == NULL) return;
+
+    if (screen->update != NULL) {
+        screen->update(now);
+    }
+
+    if (screen != current_screen || screen->duration_ms == 0) return; // Switched by the hook or untimed
+
+    // A key held over from the previous screen must be released before it can skip this one
+    if (Keyboard_ReadKey() == 0xFF) {
+        skip_armed = 1;
+    } else if (skip_armed) {
+        wait_for_key_release();
+        screen_set(screen->next);
+        return;
+    }
+
+    if ((uint32_t)(now - screen_start) >= screen->duration_ms) {
+        screen_set(screen->next);
+    }
+}
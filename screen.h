@@ -0,0 +1,44 @@
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <stdint.h>
+
+/**
+ * @brief Screen durations.
+ */
+#define SPLASH_SCREEN_MS 2000       ///< Time the startup message stays on screen.
+#define GAME_OVER_SCREEN_MS 3000    ///< Time the "Game Over" screen stays on screen.
+
+typedef struct Screen Screen;
+
+/**
+ * @brief Structure describing a screen of the user interface.
+ *
+ * Any hook may be NULL. A screen with a non-zero duration is timed: it ends
+ * by itself after that time, or earlier on a keypress, and the manager then
+ * enters @c next.
+ */
+struct Screen {
+    void (*enter)(void);            ///< Called once when the screen becomes active.
+    void (*update)(uint32_t now);   ///< Called on every pass of the main loop with the time in ms.
+    void (*exit)(void);             ///< Called once before the next screen is entered.
+    uint32_t duration_ms;           ///< Time after which a timed screen ends, 0 for untimed screens.
+    const Screen* next;             ///< Screen entered when a timed screen ends.
+};
+
+/**
+ * @brief Leaves the current screen and enters a new one.
+ *
+ * @param screen Screen to enter.
+ */
+void screen_set(const Screen* screen);
+
+/**
+ * @brief Runs one pass of the current screen.
+ *
+ * Calls the update hook and ends timed screens whose time ran out or that
+ * were skipped with a key pressed after the screen was entered.
+ */
+void screen_update(void);
+
+#endif // SCREEN_H
@@ -0,0 +1,245 @@
+#include "snapshot.h"
+#include "flash.h"
+#include "MKL05Z4.h"
+#include <string.h>
+
+// Slot layout (little endian), CRC-16/CCITT over everything before it
+#define OFS_VERSION 0
+#define OFS_FLAGS   1
+#define OFS_SEQ     2   // uint16, newest slot has the highest sequence number
+#define OFS_MAP     4
+#define OFS_LIVES   5
+#define OFS_ACTIVE  6   // uint16, pool slots of the saved balls
+#define OFS_SCORE   8   // int32
+#define OFS_SEED    12  // uint32
+#define OFS_PADDLE  16  // x, y, width
+#define OFS_BLOCKS  19  // uint16 row mask per map row
+#define OFS_DAMAGE  (OFS_BLOCKS + 2 * MAP_HEIGHT)       // Hits taken, one nibble per cell
+#define OFS_BALLS   (OFS_DAMAGE + BLOCK_CELLS_SIZE)     // x, y, dx, dy, fx, fy per saved ball, in slot order
+#define OFS_CRC     (SNAPSHOT_SIZE - 2)
+
+#define BALL_BYTES  6   // Size of one saved ball
+#define SNAPSHOT_MAX_BALLS ((OFS_CRC - OFS_BALLS) / BALL_BYTES) // Balls that fit; the rest of a multiball is dropped
+
+#define SNAPSHOT_FLAG_CLEARED 0x01 // Tombstone written by snapshot_clear()
+#define SNAPSHOT_FLAG_SERVE   0x02 // Game was saved in GAME_STATE_SERVE
+#define SNAPSHOT_VIEW_SHIFT   2    // View top is kept in the remaining flag bits
+
+#if OFS_BALLS + BALL_BYTES > OFS_CRC || BLOCK_FIELD_BOTTOM - VIEW_BLOCKS_BOTTOM > (0xFF >> SNAPSHOT_VIEW_SHIFT) || MAX_BALLS > 16 || NUM_LEVELS > 0xFF
+#error "Snapshot does not fit in SNAPSHOT_SIZE"
+#endif
+#if (SNAPSHOT_SIZE % 4) != 0
+#error "SNAPSHOT_SIZE must be a multiple of 4"
+#endif
+
+#define SLOT_ADDRESS(i) (SNAPSHOT_SECTOR + (uint32_t)(i) * SNAPSHOT_SIZE)
+#define SLOT_DATA(i) ((const uint8_t*)(uintptr_t)SLOT_ADDRESS(i)) // Slot read in place, flash is memory mapped
+
+static uint8_t slot[SNAPSHOT_SIZE];
+volatile uint8_t snapshot_power_low = 0;
+
+static uint16_t crc16(const uint8_t* data, uint8_t size) {
+    uint16_t crc = 0xFFFF;
+
+    for (uint8_t i = 0; i < size; i++) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void put_u32(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Returns 1 if the data holds a snapshot of this version
+static int slot_valid(const uint8_t* data) {
+    if (data[OFS_VERSION] != SNAPSHOT_VERSION) {
+        return 0;
+    }
+    return crc16(data, OFS_CRC) == (data[OFS_CRC] | (data[OFS_CRC + 1] << 8));
+}
+
+// Read a slot into the buffer; returns 1 if it holds a snapshot of this version
+static int read_slot(uint8_t index) {
+    Flash_Read(SLOT_ADDRESS(index), slot, SNAPSHOT_SIZE);
+    return slot_valid(slot);
+}
+
+// Find the newest valid slot and the first free one (-1 if none); leaves the slot buffer alone
+static int find_slots(int* newest, uint16_t* seq) {
+    int free_slot = -1;
+
+    *newest = -1;
+    for (uint8_t i = 0; i < SNAPSHOT_SLOTS; i++) {
+        const uint8_t* data = SLOT_DATA(i);
+        if (Flash_IsErased(SLOT_ADDRESS(i), SNAPSHOT_SIZE)) {
+            if (free_slot < 0) free_slot = i;
+            continue;
+        }
+        if (slot_valid(data)) {
+            uint16_t s = (uint16_t)(data[OFS_SEQ] | (data[OFS_SEQ + 1] << 8));
+            if (*newest < 0 || (int16_t)(s - *seq) > 0) {
+                *newest = i;
+                *seq = s;
+            }
+        }
+    }
+    return free_slot;
+}
+
+// Seal the slot buffer and program it into the next free slot. The record stays in the
+// static buffer: this runs deep in the game loop and the stack has no room for a copy.
+static int write_slot(void) {
+    int newest;
+    uint16_t seq = 0;
+
+    int free_slot = find_slots(&newest, &seq);
+    if (newest >= 0) seq++;
+    slot[OFS_SEQ] = (uint8_t)seq;
+    slot[OFS_SEQ + 1] = (uint8_t)(seq >> 8);
+    uint16_t crc = crc16(slot, OFS_CRC);
+    slot[OFS_CRC] = (uint8_t)crc;
+    slot[OFS_CRC + 1] = (uint8_t)(crc >> 8);
+
+    if (free_slot < 0) {
+        // Sector full: start over from the first slot
+        if (!Flash_EraseSector(SNAPSHOT_SECTOR)) return 0;
+        free_slot = 0;
+    }
+    return Flash_Write(SLOT_ADDRESS(free_slot), slot, SNAPSHOT_SIZE);
+}
+
+int snapshot_save(const Paddle* paddle, const BallPool* balls) {
+    memset(slot, 0, SNAPSHOT_SIZE);
+    slot[OFS_VERSION] = SNAPSHOT_VERSION;
+    slot[OFS_MAP] = (uint8_t)current_map;
+    slot[OFS_LIVES] = (uint8_t)lives;
+    slot[OFS_FLAGS] = (uint8_t)(view_top << SNAPSHOT_VIEW_SHIFT);
+    if (game_state == GAME_STATE_SERVE) {
+        slot[OFS_FLAGS] |= SNAPSHOT_FLAG_SERVE;
+    }
+    put_u32(&slot[OFS_SCORE], (uint32_t)current_score);
+    put_u32(&slot[OFS_SEED], game_seed);
+    slot[OFS_PADDLE] = paddle->x;
+    slot[OFS_PADDLE + 1] = paddle->y;
+    slot[OFS_PADDLE + 2] = paddle->width;
+
+    // Only the balls in play, at most SNAPSHOT_MAX_BALLS of them
+    uint16_t saved = 0;
+    uint8_t* ball = &slot[OFS_BALLS];
+    for (uint8_t i = 0; i < MAX_BALLS && ball < &slot[OFS_BALLS + BALL_BYTES * SNAPSHOT_MAX_BALLS]; i++) {
+        if (balls->active & BALL_BIT(i)) {
+            ball[0] = balls->x[i];
+            ball[1] = balls->y[i];
+            ball[2] = (uint8_t)balls->dx[i];
+            ball[3] = (uint8_t)balls->dy[i];
+            ball[4] = balls->fx[i];
+            ball[5] = balls->fy[i];
+            ball += BALL_BYTES;
+            saved |= BALL_BIT(i);
+        }
+    }
+    slot[OFS_ACTIVE] = (uint8_t)saved;
+    slot[OFS_ACTIVE + 1] = (uint8_t)(saved >> 8);
+    for (uint8_t row = 0; row < MAP_HEIGHT; row++) {
+        slot[OFS_BLOCKS + 2 * row] = (uint8_t)block_rows[row];
+        slot[OFS_BLOCKS + 2 * row + 1] = (uint8_t)(block_rows[row] >> 8);
+    }
+    memcpy(&slot[OFS_DAMAGE], block_damage, BLOCK_CELLS_SIZE);
+    return write_slot();
+}
+
+int snapshot_available(void) {
+    int newest;
+    uint16_t seq = 0;
+
+    find_slots(&newest, &seq);
+    return newest >= 0 && read_slot((uint8_t)newest) && !(slot[OFS_FLAGS] & SNAPSHOT_FLAG_CLEARED);
+}
+
+int snapshot_load(Paddle* paddle, BallPool* balls, uint32_t now) {
+    if (!snapshot_available()) {
+        return 0;
+    }
+
+    int map = slot[OFS_MAP] - 1;
+    if (map < 0 || map >= NUM_LEVELS) {
+        return 0;
+    }
+    game_seed = get_u32(&slot[OFS_SEED]); // Generated levels depend on it
+    current_map = map;
+    load_next_map(); // The saved map as it was when it started
+    lives = slot[OFS_LIVES];
+    current_score = (int)get_u32(&slot[OFS_SCORE]);
+    paddle->x = slot[OFS_PADDLE];
+    paddle->y = slot[OFS_PADDLE + 1];
+    paddle->width = PADDLE_WIDTH; // Expansion is not saved
+    if (paddle->x > SCREEN_WIDTH - paddle->width) {
+        paddle->x = SCREEN_WIDTH - paddle->width;
+    }
+
+    uint16_t saved = (uint16_t)(slot[OFS_ACTIVE] | (slot[OFS_ACTIVE + 1] << 8));
+    const uint8_t* ball = &slot[OFS_BALLS];
+    balls->active = 0;
+    for (uint8_t i = 0; i < MAX_BALLS; i++) {
+        if (saved & BALL_BIT(i)) {
+            balls->x[i] = ball[0];
+            balls->y[i] = ball[1];
+            balls->dx[i] = (int8_t)ball[2];
+            balls->dy[i] = (int8_t)ball[3];
+            balls->fx[i] = ball[4];
+            balls->fy[i] = ball[5];
+            ball += BALL_BYTES;
+            balls->active |= BALL_BIT(i);
+        }
+    }
+
+    uint16_t rows[MAP_HEIGHT];
+    for (uint8_t row = 0; row < MAP_HEIGHT; row++) {
+        rows[row] = (uint16_t)(slot[OFS_BLOCKS + 2 * row] | (slot[OFS_BLOCKS + 2 * row + 1] << 8));
+    }
+    block_keep_rows(rows); // Then without the blocks destroyed before the save
+    memcpy(block_damage, &slot[OFS_DAMAGE], BLOCK_CELLS_SIZE);
+    view_set(slot[OFS_FLAGS] >> SNAPSHOT_VIEW_SHIFT);
+
+    game_state = GAME_STATE_PLAY;
+    if (slot[OFS_FLAGS] & SNAPSHOT_FLAG_SERVE) {
+        ball_serve(now);
+    }
+    return 1;
+}
+
+void snapshot_clear(void) {
+    if (!snapshot_available()) {
+        return;
+    }
+
+    memset(slot, 0, SNAPSHOT_SIZE);
+    slot[OFS_VERSION] = SNAPSHOT_VERSION;
+    slot[OFS_FLAGS] = SNAPSHOT_FLAG_CLEARED;
+    write_slot();
+}
+
+// Arm the low-voltage warning so a failing supply can be saved from
+void snapshot_power_init(void) {
+    snapshot_power_low = 0;
+    PMC->LVDSC2 = PMC_LVDSC2_LVWACK_MASK | PMC_LVDSC2_LVWIE_MASK | PMC_LVDSC2_LVWV(3); // Highest warning threshold
+    NVIC_ClearPendingIRQ(LVD_LVW_IRQn);
+    NVIC_EnableIRQ(LVD_LVW_IRQn);
+}
+
+// Low-voltage warning: only flag it, the game loop saves between frames
+void LVD_LVW_IRQHandler(void) {
+    PMC->LVDSC2 = PMC_LVDSC2_LVWACK_MASK | PMC_LVDSC2_LVWV(3); // Acknowledge and fire only once
+    snapshot_power_low = 1;
+}
@@ -0,0 +1,72 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "arkanoid.h"
+#include "flash.h"
+
+/**
+ * @brief Snapshot storage parameters.
+ *
+ * Snapshots are appended to fixed-size slots of one flash sector, so a save
+ * normally programs a single slot and the sector is erased only once all
+ * of its slots are used. The newest valid slot wins.
+ */
+#define SNAPSHOT_SECTOR 0x7C00      ///< Flash address of the snapshot sector (last 1 KB sector).
+#define SNAPSHOT_SIZE 128           ///< Size of one snapshot slot in bytes (multiple of 4).
+#define SNAPSHOT_SLOTS (FLASH_SECTOR_SIZE / SNAPSHOT_SIZE) ///< Number of slots in the sector.
+#define SNAPSHOT_VERSION 6          ///< Layout version; older snapshots are ignored.
+
+/**
+ * @brief Set by the low-voltage warning interrupt; the game saves and stops.
+ */
+extern volatile uint8_t snapshot_power_low;
+
+/**
+ * @brief Enables the low-voltage warning interrupt.
+ *
+ * The interrupt only sets snapshot_power_low, the snapshot itself is
+ * written by the game loop between frames.
+ */
+void snapshot_power_init(void);
+
+/**
+ * @brief Saves the running game to flash.
+ *
+ * Stores the block cells and their damage, paddle, balls, score, lives,
+ * map, serve state and seed. Falling capsules and the paddle expansion are not saved.
+ * Only balls in play are stored, as many as the slot has room for (six with
+ * the default map size); further balls of a multiball are dropped.
+ *
+ * @param paddle Pointer to the paddle structure.
+ * @param balls Pointer to the ball pool.
+ * @return 1 if the snapshot was written, 0 on a flash error.
+ */
+int snapshot_save(const Paddle* paddle, const BallPool* balls);
+
+/**
+ * @brief Checks whether a snapshot can be resumed.
+ *
+ * @return 1 if the newest slot holds a valid snapshot, 0 otherwise.
+ */
+int snapshot_available(void);
+
+/**
+ * @brief Restores the game saved by snapshot_save().
+ *
+ * Must be called after game_init(). A game saved while serving serves
+ * again from @p now.
+ *
+ * @param paddle Filled with the saved paddle.
+ * @param balls Filled with the saved balls.
+ * @param now Current time in milliseconds.
+ * @return 1 if a snapshot was restored, 0 if none is available.
+ */
+int snapshot_load(Paddle* paddle, BallPool* balls, uint32_t now);
+
+/**
+ * @brief Discards the saved game so it cannot be resumed twice.
+ */
+void snapshot_clear(void);
+
+#endif // SNAPSHOT_H
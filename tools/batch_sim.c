@@ -0,0 +1,201 @@
+/*
+ * Headless batch simulator: plays many games with the autopilot and prints
+ * statistics as JSON.
+ *
+ * Every game starts on one map with its own seed and runs until the map is
+ * cleared, the lives run out or the tick limit is reached. The engine keeps
+ * its state in globals, as it does on the board, so games run in parallel in
+ * forked worker processes: each worker owns a private copy of the game state,
+ * nothing is shared and nothing is locked while a game runs. Workers send one
+ * fixed-size record per game back through a pipe, the parent adds them up.
+ *
+ * Build (from the project directory, Linux or another POSIX host):
+ *   cc -std=c99 -O2 -I. -Itools -o batch_sim tools/batch_sim.c tools/sim_game.c arkanoid.c \
+ *      powerup.c event_queue.c autopilot.c mapgen.c maps_packed.c bounce_table.c block_masks.c
+ *
+ * Usage: batch_sim [-g games] [-m first_map] [-n maps] [-s seed] [-j workers]
+ *                  [-t max_ticks] [-e aim_error]
+ *   -g  games per map (default 100)
+ *   -m  first map (default 0); maps from NUM_MAPS on are generated levels
+ *   -n  number of maps (default NUM_MAPS)
+ *   -s  seed of the first game, later games count up from it (default 1)
+ *   -j  worker processes (default: online CPUs)
+ *   -t  tick limit of a game (default 100000)
+ *   -e  autopilot aiming error in pixels (default AUTOPILOT_DEMO_ERROR)
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "sim_game.h"
+#include "maps.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+typedef struct {
+    int games;              // Games per map
+    int first_map;          // First map played
+    int maps;               // Number of maps played
+    uint32_t seed;          // Seed of the first game
+    int workers;            // Worker processes
+    uint32_t max_ticks;     // Tick limit of a game
+    uint8_t aim_error;      // Autopilot aiming error
+} Options;
+
+// Results of all games on one map
+typedef struct {
+    uint32_t games;
+    uint32_t cleared;
+    uint64_t clear_ticks;   // Sum over cleared games
+    uint32_t clear_min;
+    uint32_t clear_max;
+    uint64_t lives_lost;
+    uint64_t bounces;
+    uint64_t ticks;
+} MapStats;
+
+// Worker: play every workers-th game starting at the given one, report each on fd
+static void run_worker(int worker, const Options* opt, int fd) {
+    AutopilotConfig config = { opt->aim_error, AUTOPILOT_DEMO_STEP };
+    int total = opt->games * opt->maps;
+    SimResult result;
+
+    for (int n = worker; n < total; n += opt->workers) {
+        sim_play(opt->first_map + n / opt->games, opt->seed + (uint32_t)n, &config, opt->max_ticks, &result);
+        if (write(fd, &result, sizeof(result)) != (ssize_t)sizeof(result)) {
+            _exit(1);
+        }
+    }
+    _exit(0);
+}
+
+static void add_result(MapStats* stats, const SimResult* r) {
+    stats->games++;
+    stats->lives_lost += r->lives_lost;
+    stats->bounces += r->bounces;
+    stats->ticks += r->ticks;
+    if (r->cleared) {
+        if (stats->cleared == 0 || r->ticks < stats->clear_min) stats->clear_min = r->ticks;
+        if (r->ticks > stats->clear_max) stats->clear_max = r->ticks;
+        stats->cleared++;
+        stats->clear_ticks += r->ticks;
+    }
+}
+
+static double seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void print_json(const Options* opt, const MapStats* stats, double elapsed) {
+    uint64_t games = 0, ticks = 0;
+
+    for (int m = 0; m < opt->maps; m++) {
+        games += stats[m].games;
+        ticks += stats[m].ticks;
+    }
+
+    printf("{\n");
+    printf("  \"workers\": %d,\n", opt->workers);
+    printf("  \"games\": %llu,\n", (unsigned long long)games);
+    printf("  \"ticks\": %llu,\n", (unsigned long long)ticks);
+    printf("  \"seconds\": %.3f,\n", elapsed);
+    printf("  \"ticks_per_sec\": %.0f,\n", elapsed > 0 ? ticks / elapsed : 0.0);
+    printf("  \"games_per_sec\": %.1f,\n", elapsed > 0 ? games / elapsed : 0.0);
+    printf("  \"maps\": [\n");
+    for (int m = 0; m < opt->maps; m++) {
+        const MapStats* s = &stats[m];
+        double n = s->games ? (double)s->games : 1.0;
+        printf("    {\"map\": %d, \"generated\": %s, \"games\": %u, \"cleared\": %u, ",
+               opt->first_map + m, (opt->first_map + m >= NUM_MAPS) ? "true" : "false", s->games, s->cleared);
+        printf("\"clear_ticks\": {\"mean\": %.1f, \"min\": %u, \"max\": %u}, ",
+               s->cleared ? (double)s->clear_ticks / s->cleared : 0.0, s->clear_min, s->clear_max);
+        printf("\"lives_lost_mean\": %.3f, \"bounces_mean\": %.1f}%s\n",
+               s->lives_lost / n, s->bounces / n, (m + 1 < opt->maps) ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [-g games] [-m first_map] [-n maps] [-s seed] [-j workers] [-t max_ticks] [-e aim_error]\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    Options opt = { 100, 0, NUM_MAPS, 1, 0, 100000, AUTOPILOT_DEMO_ERROR };
+    int c;
+
+    while ((c = getopt(argc, argv, "g:m:n:s:j:t:e:")) != -1) {
+        switch (c) {
+            case 'g': opt.games = atoi(optarg); break;
+            case 'm': opt.first_map = atoi(optarg); break;
+            case 'n': opt.maps = atoi(optarg); break;
+            case 's': opt.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'j': opt.workers = atoi(optarg); break;
+            case 't': opt.max_ticks = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'e': opt.aim_error = (uint8_t)atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        opt.workers = (cpus > 0) ? (int)cpus : 1;
+    }
+    if (opt.games <= 0 || opt.maps <= 0 || opt.first_map < 0 || opt.first_map + opt.maps > NUM_LEVELS) {
+        fprintf(stderr, "Maps must lie within 0..%d and there must be at least one game\n", NUM_LEVELS - 1);
+        return 2;
+    }
+    if (opt.workers > opt.games * opt.maps) {
+        opt.workers = opt.games * opt.maps;
+    }
+
+    MapStats* stats = calloc((size_t)opt.maps, sizeof(MapStats));
+    int fds[2];
+    if (stats == NULL || pipe(fds) != 0) {
+        perror("batch_sim");
+        return 1;
+    }
+
+    double start = seconds();
+    for (int w = 0; w < opt.workers; w++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            run_worker(w, &opt, fds[1]);
+        }
+    }
+    close(fds[1]);
+
+    // Records are smaller than PIPE_BUF, so writes from different workers never interleave
+    SimResult result;
+    ssize_t got;
+    while ((got = read(fds[0], &result, sizeof(result))) == (ssize_t)sizeof(result)) {
+        add_result(&stats[result.map - opt.first_map], &result);
+    }
+    close(fds[0]);
+
+    int failed = (got != 0);
+    int status;
+    while (wait(&status) > 0) {
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    double elapsed = seconds() - start;
+
+    print_json(&opt, stats, elapsed);
+    free(stats);
+    if (failed) {
+        fprintf(stderr, "batch_sim: a worker failed\n");
+        return 1;
+    }
+    return 0;
+}
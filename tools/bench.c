@@ -0,0 +1,740 @@
+/*
+ * Micro and macro benchmarks of the display driver, the renderer and the game
+ * engine on a host, printed as JSON, with an optional regression gate.
+ *
+ * oled.c and game_draw.c are built unchanged against tools/host/MKL05Z4.h; the
+ * SPI and GPIO calls they make land in this file, which counts the bytes sent
+ * to the display and the transactions (chip select pulses) instead of driving
+ * pins. Bus counts are exact and the same on every host, so they gate reliably.
+ * Times are process CPU time, so time given to other processes does not count.
+ * A shared machine still has slow spells (caches and memory bandwidth taken
+ * by its neighbours) that last up to seconds and only ever add time, so the
+ * benchmarks are timed in rounds of one short sample each for at least
+ * BENCH_RUN_SECONDS, and a time is the lower quartile of its samples. The
+ * spread of the fastest half of the samples (median absolute deviation) is
+ * reported beside it.
+ *
+ * Every benchmark reports nanoseconds, bus bytes and bus transactions per
+ * operation. Given a baseline file written by an earlier run, each metric is
+ * compared with the baseline of the same benchmark, and the run exits with 1
+ * when any of them grew by more than the allowed percentage. A time must also
+ * grow by more than BENCH_MIN_DELTA_NS and by more than BENCH_NOISE_MADS times
+ * the spread of its samples, and keep doing so when the benchmark is timed
+ * again BENCH_CONFIRM_RUNS times, so noise alone does not fail a run.
+ *
+ * Build (from the project directory, without ARKANOID_HOST so the asserts stay out of the timings):
+ *   cc -std=c99 -O2 -I. -Itools/host -o bench tools/bench.c oled.c game_draw.c Fonts.c effects.c \
+ *      arkanoid.c powerup.c event_queue.c mapgen.c maps_packed.c bounce_table.c block_masks.c
+ *
+ * The 16-ball pool benchmark needs a pool that large: add -DMAX_BALLS=16.
+ *
+ * Usage: bench [-o results.json] [-b baseline.json] [-x percent] [-f filter]
+ *   -o  also write the results to a file, to be used as a later baseline
+ *   -b  baseline to compare with
+ *   -x  allowed growth of a metric over the baseline in percent (default 10)
+ *   -f  only run benchmarks whose name contains this text
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "arkanoid.h"
+#include "event_queue.h"
+#include "effects.h"
+#include "game_draw.h"
+#include "oled.h"
+#include "maps.h"
+#include "mapgen.h"
+#include "gpio.h"
+#include "spi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_SAMPLE_SECONDS 0.01 // CPU time of one timed sample
+#define BENCH_RUN_SECONDS 4.0   // Shortest CPU time of all the timed rounds together
+#define BENCH_MIN_SAMPLES 15    // Fewest timed samples per benchmark
+#define BENCH_MAX_SAMPLES 512   // Most timed samples per benchmark
+#define BENCH_MIN_DELTA_NS 2.0  // Smallest time growth per operation that can fail a run
+#define BENCH_NOISE_MADS 4.0    // Time growth within this many deviations of the samples is noise
+#define BENCH_CONFIRM_RUNS 2    // Times a regressed time is measured again before it fails the run
+#define BENCH_BUS_OPS 64        // Operations whose bus traffic is averaged
+#define BENCH_EPISODE_TICKS 256 // Engine ticks of one ball benchmark operation
+#define LINE_SIZE 256
+
+typedef struct {
+    const char* name;
+    void (*setup)(int arg);     // Prepares the state, not timed; may be NULL
+    void (*op)(int arg);        // One operation; the same work every time it runs after setup
+    int arg;
+    int units;                  // Work items in one operation; results are per item
+} Bench;
+
+typedef struct {
+    const char* name;
+    double ns;                  // Per operation
+    double ns_mad;              // Median absolute deviation of the timed samples
+    double bytes;               // Bytes sent to the display per operation
+    double transactions;        // Chip select pulses per operation
+} Result;
+
+/* Display bus stand-ins for oled.c */
+
+static uint32_t bus_bytes;
+static uint32_t bus_transactions;
+
+void gpio_set_output(PORT_Type* port, GPIO_Type* gpio, uint32_t pin) {
+    (void)port;
+    (void)gpio;
+    (void)pin;
+}
+
+void gpio_set_high(GPIO_Type* gpio, uint32_t pin) {
+    (void)gpio;
+    (void)pin;
+}
+
+void gpio_set_low(GPIO_Type* gpio, uint32_t pin) {
+    (void)pin;
+    if (gpio == GPIOA) {
+        bus_transactions++; // Chip select, the driver's only pin on port A, goes low once per transfer
+    }
+}
+
+uint8_t spi_master_write(uint8_t data) {
+    (void)data;
+    bus_bytes++;
+    return 0;
+}
+
+/* Renderer benchmarks */
+
+typedef struct {
+    uint8_t width, height;
+} SpriteSize;
+
+// The game's sprites (ball, capsule, HUD icon, block) and a large one
+static const SpriteSize sprite_sizes[] = { { 2, 2 }, { 8, 4 }, { 8, 8 }, { 12, 6 }, { 32, 16 } };
+
+static const uint8_t sprite_pattern[16] = {
+    0xA5, 0x5A, 0xFF, 0x81, 0xC3, 0x3C, 0x99, 0x66, 0xA5, 0x5A, 0xFF, 0x81, 0xC3, 0x3C, 0x99, 0x66
+};
+
+static void setup_screen(int arg) {
+    (void)arg;
+    ssd1306_clear_screen(0x00);
+}
+
+static void op_draw_bitmap(int arg) {
+    // Odd x and y: the sprite straddles two pages, as moving ones mostly do
+    draw_bitmap(37, 21, sprite_pattern, sprite_sizes[arg].width, sprite_sizes[arg].height);
+}
+
+static void op_display_string(int size) {
+    ssd1306_display_string(0, 16, (const uint8_t*)"SCORE 012345", (uint8_t)size, 1);
+}
+
+static void op_clear_screen(int arg) {
+    (void)arg;
+    ssd1306_clear_screen(0x00);
+}
+
+static void op_refresh_gram(int arg) {
+    (void)arg;
+    ssd1306_refresh_gram();
+}
+
+/* Engine benchmarks */
+
+static Paddle paddle;
+static Ball ball;
+static BallPool balls;
+static volatile int sink;        // Keeps results of pure calls alive
+
+static void start_ball(void) {
+    ball.x = (SCREEN_WIDTH / 2) - BALL_SIZE;
+    ball.y = paddle.y - BALL_SIZE;
+    ball.fx = ball.fy = 0;
+    ball_aim(&ball, BOUNCE_SERVE_ANGLE);
+}
+
+// Rows of blocks the view shows above the paddle with the view at the top
+#define FIELD_ROWS ((VIEW_BLOCKS_BOTTOM + 1 - PLAYFIELD_TOP) / BLOCK_PITCH_Y)
+
+// Dense record of a width x rows field with the given percentage of the cells, spread evenly, of one block type
+static void build_field(uint8_t* record, int width, int rows, int percent, uint8_t type) {
+    int cells = width * rows;
+
+    memset(record, 0, MAPGEN_RECORD_SIZE);
+    record[0] = MAP_FORMAT_DENSE;
+    record[1] = (uint8_t)(width | (rows << 4));
+    for (int index = 0; index < cells; index++) {
+        if ((index * percent) / 100 != ((index + 1) * percent) / 100) {
+            record[2 + (index >> 1)] |= (index & 1) ? (uint8_t)(type << 4) : type;
+        }
+    }
+}
+
+// Start a game on a steel field, so hits never change it, with the view scrolled down to its lowest row
+static void start_field(int rows, int percent) {
+    uint8_t record[MAPGEN_RECORD_SIZE];
+    int bottom = BLOCK_Y(rows - 1) + BLOCK_HEIGHT;
+
+    build_field(record, MAP_WIDTH, rows, percent, BLOCK_TYPE_STEEL);
+    event_queue_init();
+    game_init();
+    convert_map(record);
+    view_set((uint8_t)((bottom > VIEW_BLOCKS_BOTTOM) ? bottom - VIEW_BLOCKS_BOTTOM : 0));
+    paddle.x = (SCREEN_WIDTH - PADDLE_WIDTH) / 2;
+    paddle.y = (uint8_t)(view_top + PADDLE_VIEW_Y);
+    paddle.width = PADDLE_WIDTH;
+    start_ball();
+}
+
+static void setup_density(int percent) {
+    start_field(FIELD_ROWS, percent);
+}
+
+// Half-full fields of a growing number of rows: the rows above the view must not cost anything
+static void setup_rows(int rows) {
+    start_field(rows, 50);
+}
+
+// One episode of BENCH_EPISODE_TICKS ticks from a served ball; steel keeps the map the same for the next one
+static void op_ball_update(int arg) {
+    Event event;
+
+    (void)arg;
+    start_ball();
+    for (int tick = 0; tick < BENCH_EPISODE_TICKS; tick++) {
+        paddle.x = (uint8_t)(ball.x > PADDLE_WIDTH / 2 ? ball.x - PADDLE_WIDTH / 2 : 0); // Never miss
+        if (paddle.x > SCREEN_WIDTH - PADDLE_WIDTH) {
+            paddle.x = SCREEN_WIDTH - PADDLE_WIDTH;
+        }
+        if (!ball_update(&ball, &paddle)) {
+            start_ball();
+        }
+        while (event_poll(&event)) {
+        }
+    }
+}
+
+// Field of the pool benchmarks: a quarter of the view's cells steel, and a paddle as wide as the screen that never misses
+static void setup_pool(int count) {
+    (void)count;
+    setup_density(25);
+    paddle.x = 0;
+    paddle.width = SCREEN_WIDTH;
+}
+
+// One episode of BENCH_EPISODE_TICKS ticks of the given number of balls, served from along the paddle in spread directions
+static void op_ball_pool_update(int count) {
+    Event event;
+    Ball spawn;
+
+    balls.active = 0;
+    for (int i = 0; i < count; i++) {
+        spawn.x = (uint8_t)(4 + i * 7);
+        spawn.y = paddle.y - BALL_SIZE;
+        spawn.fx = spawn.fy = 0;
+        ball_aim(&spawn, (uint8_t)((i * 5 + 3) % BOUNCE_ANGLES));
+        ball_pool_spawn(&balls, &spawn);
+    }
+    for (int tick = 0; tick < BENCH_EPISODE_TICKS; tick++) {
+        ball_pool_update(&balls, &paddle, 0);
+        while (event_poll(&event)) {
+        }
+    }
+}
+
+static void setup_map(int arg) {
+    (void)arg;
+    event_queue_init();
+    game_init();
+}
+
+static void op_check_map_complete(int arg) {
+    (void)arg;
+    sink = check_map_complete();
+}
+
+// Every predefined map once, so each operation converts the same records
+static void op_convert_map(int arg) {
+    (void)arg;
+    for (int index = 0; index < NUM_MAPS; index++) {
+        convert_map(&maps_data[maps_offset[index]]);
+    }
+}
+
+/* Narrow phase benchmarks */
+
+#define NARROW_CANDIDATES 64    // Ball motions tested against the block per operation
+#define NARROW_COL 4            // Column of the block, in row 0
+#define NARROW_NEAR 0x100       // Benchmark argument flag: balls all around the block instead of below it
+
+static BallMotion candidates[NARROW_CANDIDATES];
+
+/*
+ * One block of the given cell type and the balls the broadphase hands over for it.
+ * By default they sit just below the block and all reach its box, so each one is a
+ * full swept test. With NARROW_NEAR they start up to 2 pixels below or above the
+ * block, across it and past its edges, and fly every bounce direction towards it:
+ * many miss it or only pass between its lit pixels, as in play.
+ *
+ * A motion that cannot reach a lit pixel is rejected without a division, in a
+ * few nanoseconds. A hit cannot get that cheap: its time of impact is a
+ * quotient per axis, which is what the box case costs, and a mask adds one for
+ * each column and pixel row line it reaches. The software divisions of the
+ * Cortex-M0+ make those the bulk of the cost there.
+ */
+static void setup_narrow(int arg) {
+    uint8_t record[MAPGEN_RECORD_SIZE];
+    uint32_t random = 12345;
+
+    build_field(record, MAP_WIDTH, 1, 0, 0);
+    record[2 + (NARROW_COL >> 1)] = (uint8_t)((arg & 0x0F) << ((NARROW_COL & 1) * 4));
+    event_queue_init();
+    game_init();
+    convert_map(record);
+    view_set(0);
+    for (int i = 0; i < NARROW_CANDIDATES; i++) {
+        if (arg & NARROW_NEAR) {
+            Ball ball;
+            random = random * 1103515245u + 12345u;
+            ball_aim(&ball, (uint8_t)(i % BOUNCE_ANGLES));
+            int32_t gap = (int32_t)((random >> 20) % (2 << 8));
+            candidates[i].x = ((int32_t)(BLOCK_X(NARROW_COL) - BALL_SIZE - 2) << 8) + (int32_t)((random >> 8) % ((BLOCK_WIDTH + BALL_SIZE + 4) << 8));
+            candidates[i].dx = ball.dx;
+            if (i & 16) {
+                candidates[i].y = ((int32_t)(BLOCK_Y(0) - BALL_SIZE) << 8) - gap; // Falling onto the block
+                candidates[i].dy = (int8_t)-ball.dy;
+            } else {
+                candidates[i].y = ((int32_t)(BLOCK_Y(0) + BLOCK_HEIGHT) << 8) + gap;
+                candidates[i].dy = ball.dy;
+            }
+            continue;
+        }
+        int x = BLOCK_X(NARROW_COL) - BALL_SIZE - 2 + i % (BLOCK_WIDTH + 6);
+        candidates[i].x = ((int32_t)x << 8) | ((i * 37) & 0xFF); // Across the block and past its edges
+        candidates[i].y = (int32_t)(BLOCK_Y(0) + BLOCK_HEIGHT) << 8;
+        candidates[i].dx = (int8_t)((i % 7 - 3) * 8);
+        candidates[i].dy = -BALL_SPEED_DEFAULT;
+    }
+}
+
+static void op_check_collision(int arg) {
+    Contact contact;
+    int hits = 0;
+
+    (void)arg;
+    for (int i = 0; i < NARROW_CANDIDATES; i++) {
+        hits += check_collision(&candidates[i], 0, NARROW_COL, SWEEP_ONE, &contact);
+    }
+    sink = hits;
+}
+
+/* Map size benchmarks */
+
+// Fields of the size sweep, named WIDTHxROWS_PERCENT in the table below
+static const struct {
+    uint8_t width, rows, percent;
+} sweep_fields[] = {
+    { 5, 2, 10 }, { 5, 2, 50 }, { 5, 2, 100 },
+    { 10, 4, 10 }, { 10, 4, 50 }, { 10, 4, 100 },
+    { 10, 10, 10 }, { 10, 10, 50 }, { 10, 10, 100 },
+};
+
+static uint8_t sweep_record[3 + 2 * NUM_BLOCKS]; // Room for a sparse record of every cell
+
+// The record of a sweep field in the smaller of the two formats, as tools/pack_maps.py picks it
+static void setup_sweep(int arg) {
+    uint8_t dense[MAPGEN_RECORD_SIZE];
+    int width = sweep_fields[arg].width;
+    int rows = sweep_fields[arg].rows;
+    int count = 0;
+
+    build_field(dense, width, rows, sweep_fields[arg].percent, 1);
+    sweep_record[0] = MAP_FORMAT_SPARSE;
+    sweep_record[1] = dense[1];
+    for (int index = 0; index < width * rows; index++) {
+        uint8_t type = (dense[2 + (index >> 1)] >> ((index & 1) * 4)) & 0x0F;
+        if (type != 0) {
+            sweep_record[3 + 2 * count] = BLOCK_INDEX(index / width, index % width);
+            sweep_record[4 + 2 * count] = type;
+            count++;
+        }
+    }
+    sweep_record[2] = (uint8_t)count;
+    if (3 + 2 * count >= 2 + (width * rows + 1) / 2) {
+        memcpy(sweep_record, dense, sizeof(dense));
+    }
+
+    event_queue_init();
+    game_init();
+}
+
+static void op_convert_sweep(int arg) {
+    (void)arg;
+    convert_map(sweep_record);
+}
+
+/* Frame benchmarks */
+
+static void setup_game(int arg) {
+    (void)arg;
+    event_queue_init();
+    game_init();
+    effects_init();
+    paddle.x = (SCREEN_WIDTH - PADDLE_WIDTH) / 2;
+    paddle.y = PADDLE_VIEW_Y;
+    paddle.width = PADDLE_WIDTH;
+    start_ball();
+    ball_pool_init(&balls, &ball);
+    draw_invalidate();
+    draw_game(&paddle, &balls);
+}
+
+// A frame of a sweep field, with the view scrolled down to its lowest row
+static void setup_sweep_game(int arg) {
+    setup_sweep(arg);
+    setup_game(0);
+    convert_map(sweep_record);
+    view_update(&paddle, &balls);
+    start_ball();
+    ball_pool_init(&balls, &ball);
+    draw_invalidate();
+    draw_game(&paddle, &balls);
+}
+
+static void op_draw_game_full(int arg) {
+    (void)arg;
+    draw_invalidate();
+    draw_game(&paddle, &balls);
+}
+
+static void op_draw_game_move(int arg) {
+    (void)arg;
+    paddle.x ^= 4; // Paddle steps back and forth, the rest of the frame stays
+    draw_game(&paddle, &balls);
+}
+
+static const Bench benches[] = {
+    { "draw_bitmap/2x2", setup_screen, op_draw_bitmap, 0, 1 },
+    { "draw_bitmap/8x4", setup_screen, op_draw_bitmap, 1, 1 },
+    { "draw_bitmap/8x8", setup_screen, op_draw_bitmap, 2, 1 },
+    { "draw_bitmap/12x6", setup_screen, op_draw_bitmap, 3, 1 },
+    { "draw_bitmap/32x16", setup_screen, op_draw_bitmap, 4, 1 },
+    { "ssd1306_display_string/12", setup_screen, op_display_string, 12, 1 },
+    { "ssd1306_display_string/16", setup_screen, op_display_string, 16, 1 },
+    { "ssd1306_clear_screen", setup_screen, op_clear_screen, 0, 1 },
+    { "ssd1306_refresh_gram", setup_screen, op_refresh_gram, 0, 1 },
+    { "ball_update/density_0", setup_density, op_ball_update, 0, BENCH_EPISODE_TICKS },
+    { "ball_update/density_25", setup_density, op_ball_update, 25, BENCH_EPISODE_TICKS },
+    { "ball_update/density_50", setup_density, op_ball_update, 50, BENCH_EPISODE_TICKS },
+    { "ball_update/density_100", setup_density, op_ball_update, 100, BENCH_EPISODE_TICKS },
+    { "ball_update/rows_1", setup_rows, op_ball_update, 1, BENCH_EPISODE_TICKS },
+    { "ball_update/rows_4", setup_rows, op_ball_update, 4, BENCH_EPISODE_TICKS },
+    { "ball_update/rows_7", setup_rows, op_ball_update, 7, BENCH_EPISODE_TICKS },
+    { "ball_update/rows_10", setup_rows, op_ball_update, 10, BENCH_EPISODE_TICKS },
+    { "ball_pool_update/balls_1", setup_pool, op_ball_pool_update, 1, BENCH_EPISODE_TICKS },
+    { "ball_pool_update/balls_4", setup_pool, op_ball_pool_update, 4, BENCH_EPISODE_TICKS },
+#if MAX_BALLS >= 16
+    { "ball_pool_update/balls_16", setup_pool, op_ball_pool_update, 16, BENCH_EPISODE_TICKS },
+#endif
+    { "check_collision/box", setup_narrow, op_check_collision, 0x0F, NARROW_CANDIDATES },
+    { "check_collision/mask_plain", setup_narrow, op_check_collision, BLOCK_TYPE_2, NARROW_CANDIDATES },
+    { "check_collision/mask_steel", setup_narrow, op_check_collision, BLOCK_TYPE_STEEL, NARROW_CANDIDATES },
+    { "check_collision/mask_wood", setup_narrow, op_check_collision, BLOCK_TYPE_WOOD, NARROW_CANDIDATES },
+    { "check_collision/near_box", setup_narrow, op_check_collision, 0x0F | NARROW_NEAR, NARROW_CANDIDATES },
+    { "check_collision/near_plain", setup_narrow, op_check_collision, BLOCK_TYPE_2 | NARROW_NEAR, NARROW_CANDIDATES },
+    { "check_collision/near_steel", setup_narrow, op_check_collision, BLOCK_TYPE_STEEL | NARROW_NEAR, NARROW_CANDIDATES },
+    { "check_collision/near_wood", setup_narrow, op_check_collision, BLOCK_TYPE_WOOD | NARROW_NEAR, NARROW_CANDIDATES },
+    { "check_map_complete", setup_map, op_check_map_complete, 0, 1 },
+    { "convert_map", setup_map, op_convert_map, 0, NUM_MAPS },
+    { "convert_map/5x2_10", setup_sweep, op_convert_sweep, 0, 1 },
+    { "convert_map/5x2_50", setup_sweep, op_convert_sweep, 1, 1 },
+    { "convert_map/5x2_100", setup_sweep, op_convert_sweep, 2, 1 },
+    { "convert_map/10x4_10", setup_sweep, op_convert_sweep, 3, 1 },
+    { "convert_map/10x4_50", setup_sweep, op_convert_sweep, 4, 1 },
+    { "convert_map/10x4_100", setup_sweep, op_convert_sweep, 5, 1 },
+    { "convert_map/10x10_10", setup_sweep, op_convert_sweep, 6, 1 },
+    { "convert_map/10x10_50", setup_sweep, op_convert_sweep, 7, 1 },
+    { "convert_map/10x10_100", setup_sweep, op_convert_sweep, 8, 1 },
+    { "draw_game/full", setup_game, op_draw_game_full, 0, 1 },
+    { "draw_game/paddle_move", setup_game, op_draw_game_move, 0, 1 },
+    { "draw_game/5x2_10", setup_sweep_game, op_draw_game_full, 0, 1 },
+    { "draw_game/5x2_50", setup_sweep_game, op_draw_game_full, 1, 1 },
+    { "draw_game/5x2_100", setup_sweep_game, op_draw_game_full, 2, 1 },
+    { "draw_game/10x4_10", setup_sweep_game, op_draw_game_full, 3, 1 },
+    { "draw_game/10x4_50", setup_sweep_game, op_draw_game_full, 4, 1 },
+    { "draw_game/10x4_100", setup_sweep_game, op_draw_game_full, 5, 1 },
+    { "draw_game/10x10_10", setup_sweep_game, op_draw_game_full, 6, 1 },
+    { "draw_game/10x10_50", setup_sweep_game, op_draw_game_full, 7, 1 },
+    { "draw_game/10x10_100", setup_sweep_game, op_draw_game_full, 8, 1 },
+};
+
+#define NUM_BENCHES ((int)(sizeof(benches) / sizeof(benches[0])))
+
+typedef struct {
+    const char* output;     // Results file, or NULL
+    const char* baseline;   // Baseline file, or NULL
+    double threshold;       // Allowed growth in percent
+    const char* filter;     // Substring of the names to run, or NULL
+} Options;
+
+// CPU time of this process: time the scheduler gives to other work does not count
+static double cpu_seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Median of sorted values
+static double median(const double* values, int count) {
+    return (count & 1) ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+// CPU time of a run of the given number of operations, from a fresh setup
+static double time_ops(const Bench* bench, long ops) {
+    if (bench->setup) bench->setup(bench->arg);
+    double start = cpu_seconds();
+    for (long i = 0; i < ops; i++) {
+        bench->op(bench->arg);
+    }
+    return cpu_seconds() - start;
+}
+
+// Bus traffic over a fixed number of operations, so it does not depend on the timing
+static void measure_bus(const Bench* bench, Result* result) {
+    if (bench->setup) bench->setup(bench->arg);
+    bus_bytes = bus_transactions = 0;
+    for (int i = 0; i < BENCH_BUS_OPS; i++) {
+        bench->op(bench->arg);
+    }
+    result->bytes = (double)bus_bytes / ((double)BENCH_BUS_OPS * bench->units);
+    result->transactions = (double)bus_transactions / ((double)BENCH_BUS_OPS * bench->units);
+}
+
+// Double the operations until a run is long enough to time
+static long calibrate(const Bench* bench) {
+    long ops;
+
+    for (ops = 1; time_ops(bench, ops) < BENCH_SAMPLE_SECONDS; ops *= 2) {
+    }
+    return ops;
+}
+
+// Time the benchmarks in rounds of one sample each, so every one of them sees the slow spells of the machine
+static void run_benches(const Bench* const* run, Result* results, int count) {
+    static double samples[NUM_BENCHES][BENCH_MAX_SAMPLES];
+    double deviations[BENCH_MAX_SAMPLES / 2];
+    long ops[NUM_BENCHES];
+    int rounds = 0;
+
+    for (int i = 0; i < count; i++) {
+        results[i].name = run[i]->name;
+        measure_bus(run[i], &results[i]);
+        ops[i] = calibrate(run[i]);
+    }
+    double start = cpu_seconds();
+    while (rounds < BENCH_MAX_SAMPLES && (rounds < BENCH_MIN_SAMPLES || cpu_seconds() - start < BENCH_RUN_SECONDS)) {
+        for (int i = 0; i < count; i++) {
+            samples[i][rounds] = time_ops(run[i], ops[i]) * 1e9 / ((double)ops[i] * run[i]->units);
+        }
+        rounds++;
+    }
+    for (int i = 0; i < count; i++) {
+        int fast = rounds / 2;
+        qsort(samples[i], (size_t)rounds, sizeof(samples[i][0]), compare_doubles);
+        results[i].ns = samples[i][rounds / 4];
+        double centre = median(samples[i], fast);
+        for (int s = 0; s < fast; s++) {
+            deviations[s] = (samples[i][s] > centre) ? samples[i][s] - centre : centre - samples[i][s];
+        }
+        qsort(deviations, (size_t)fast, sizeof(deviations[0]), compare_doubles);
+        results[i].ns_mad = median(deviations, fast);
+    }
+}
+
+// Metrics of one benchmark in a results file written by print_json(); 0 if not found
+static int find_baseline(const char* path, const char* name, Result* base) {
+    FILE* f = fopen(path, "r");
+    char line[LINE_SIZE];
+    char key[LINE_SIZE];
+    int found = 0;
+
+    if (f == NULL) {
+        return 0;
+    }
+    snprintf(key, sizeof(key), "\"name\": \"%s\",", name);
+    while (!found && fgets(line, sizeof(line), f)) {
+        const char* at = strstr(line, key);
+        if (at != NULL) {
+            found = sscanf(at + strlen(key),
+                           " \"ns_per_op\": %lf, \"ns_mad\": %lf, \"bus_bytes\": %lf, \"bus_transactions\": %lf",
+                           &base->ns, &base->ns_mad, &base->bytes, &base->transactions) == 4;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+// Growth of a metric over its baseline in percent; a metric that was 0 counts as 100% per unit
+static double growth(double value, double base) {
+    return (base > 0.0) ? (value - base) * 100.0 / base : value * 100.0;
+}
+
+// Time growth per operation that noise can explain: the larger spread of the two runs, or the floor
+static double noise_limit(const Result* result, const Result* base) {
+    double mad = (result->ns_mad > base->ns_mad) ? result->ns_mad : base->ns_mad;
+    return (BENCH_NOISE_MADS * mad > BENCH_MIN_DELTA_NS) ? BENCH_NOISE_MADS * mad : BENCH_MIN_DELTA_NS;
+}
+
+// A time grew by more than the threshold and more than noise can explain
+static int time_regressed(const Options* opt, const Result* result, const Result* base) {
+    return growth(result->ns, base->ns) > opt->threshold && result->ns - base->ns > noise_limit(result, base);
+}
+
+// Time again the benchmarks whose time regressed, keeping the faster result, so a slow spell during one measurement does not fail the run
+static void confirm_regressions(const Options* opt, const Bench* const* run, Result* results, int count) {
+    const Bench* again[NUM_BENCHES];
+    Result retimed[NUM_BENCHES];
+    int index[NUM_BENCHES];
+
+    for (int attempt = 0; attempt < BENCH_CONFIRM_RUNS; attempt++) {
+        int suspects = 0;
+        for (int i = 0; i < count; i++) {
+            Result base;
+            if (find_baseline(opt->baseline, results[i].name, &base) && time_regressed(opt, &results[i], &base)) {
+                again[suspects] = run[i];
+                index[suspects++] = i;
+            }
+        }
+        if (suspects == 0) {
+            return;
+        }
+        run_benches(again, retimed, suspects);
+        for (int s = 0; s < suspects; s++) {
+            if (retimed[s].ns < results[index[s]].ns) {
+                results[index[s]] = retimed[s];
+            }
+        }
+    }
+}
+
+static void print_metric(FILE* out, const char* name, const char* metric, double value, double base, int* first) {
+    fprintf(out, "%s\n    {\"name\": \"%s\", \"metric\": \"%s\", \"baseline\": %.2f, \"value\": %.2f, \"growth_pct\": %.1f}",
+            *first ? "" : ",", name, metric, base, value, growth(value, base));
+    *first = 0;
+}
+
+// Print the results, and the regressions if there is a baseline; returns the number of regressions
+static int print_json(FILE* out, const Options* opt, const Result* results, int count) {
+    int regressions = 0;
+    int first = 1;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmarks\": [\n");
+    for (int i = 0; i < count; i++) {
+        const Result* r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"ns_mad\": %.2f, \"bus_bytes\": %.2f, \"bus_transactions\": %.2f}%s\n",
+                r->name, r->ns, r->ns_mad, r->bytes, r->transactions, (i + 1 < count) ? "," : "");
+    }
+    if (opt->baseline == NULL) {
+        fprintf(out, "  ]\n");
+        fprintf(out, "}\n");
+        return 0;
+    }
+
+    fprintf(out, "  ],\n");
+    fprintf(out, "  \"baseline\": \"%s\",\n", opt->baseline);
+    fprintf(out, "  \"threshold_pct\": %.1f,\n", opt->threshold);
+    fprintf(out, "  \"min_delta_ns\": %.1f,\n", BENCH_MIN_DELTA_NS);
+    fprintf(out, "  \"regressions\": [");
+    for (int i = 0; i < count; i++) {
+        const Result* r = &results[i];
+        Result base;
+        if (!find_baseline(opt->baseline, r->name, &base)) {
+            continue; // New benchmark
+        }
+        if (time_regressed(opt, r, &base)) {
+            print_metric(out, r->name, "ns_per_op", r->ns, base.ns, &first);
+            regressions++;
+        }
+        if (growth(r->bytes, base.bytes) > opt->threshold) {
+            print_metric(out, r->name, "bus_bytes", r->bytes, base.bytes, &first);
+            regressions++;
+        }
+        if (growth(r->transactions, base.transactions) > opt->threshold) {
+            print_metric(out, r->name, "bus_transactions", r->transactions, base.transactions, &first);
+            regressions++;
+        }
+    }
+    fprintf(out, "%s]\n", first ? "" : "\n  ");
+    fprintf(out, "}\n");
+    return regressions;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [-o results.json] [-b baseline.json] [-x percent] [-f filter]\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    Options opt = { NULL, NULL, 10.0, NULL };
+    Result results[NUM_BENCHES];
+    const Bench* run[NUM_BENCHES];
+    int count = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "o:b:x:f:")) != -1) {
+        switch (c) {
+            case 'o': opt.output = optarg; break;
+            case 'b': opt.baseline = optarg; break;
+            case 'x': opt.threshold = atof(optarg); break;
+            case 'f': opt.filter = optarg; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.baseline != NULL) {
+        FILE* f = fopen(opt.baseline, "r");
+        if (f == NULL) {
+            perror(opt.baseline);
+            return 2;
+        }
+        fclose(f);
+    }
+
+    for (int i = 0; i < NUM_BENCHES; i++) {
+        if (opt.filter == NULL || strstr(benches[i].name, opt.filter) != NULL) {
+            run[count++] = &benches[i];
+        }
+    }
+    run_benches(run, results, count);
+    if (opt.baseline != NULL) {
+        confirm_regressions(&opt, run, results, count);
+    }
+
+    int regressions = print_json(stdout, &opt, results, count);
+    if (opt.output != NULL) {
+        FILE* f = fopen(opt.output, "w");
+        if (f == NULL) {
+            perror(opt.output);
+            return 2;
+        }
+        print_json(f, &opt, results, count);
+        fclose(f);
+    }
+    if (regressions > 0) {
+        fprintf(stderr, "bench: %d metric(s) regressed by more than %.1f%%\n", regressions, opt.threshold);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * Host checks of the game engine. Each test prints one line and the run
+ * exits with 1 if any check failed.
+ *
+ * Build (from the project directory):
+ *   cc -std=c99 -O2 -DARKANOID_HOST -I. -o engine_test tools/engine_test.c arkanoid.c powerup.c \
+ *      event_queue.c mapgen.c maps_packed.c bounce_table.c block_masks.c replay.c
+ *
+ * Usage: engine_test [replay_image]
+ *
+ * With an argument, the replay region of the reference game (see
+ * test_replay()) is written to that file, for playing it back on a board.
+ */
+#include "arkanoid.h"
+#include "event_queue.h"
+#include "powerup.h"
+#include "replay.h"
+#include "mapgen.h"
+#include "maps.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SLOWEST_DX 7    // Smallest horizontal speed in the bounce table at the default ball speed
+#define MAPGEN_LEVELS 30 // Generated levels checked per seed
+#define REPLAY_SEED 1u   // Game seed of the replay reference game
+#define REPLAY_HASH 0xEE659CF5u // State hash at the end of the reference recording
+#define REPLAY_MAX_TICKS 60000
+
+// Seeds of the generator test and the digest of their first MAPGEN_LEVELS levels
+static const struct {
+    uint32_t seed;
+    uint32_t digest;
+} mapgen_golden[] = {
+    { 1u, 0x694BECFDu },
+    { 2u, 0xA9B16D0Du },
+    { 0x12345678u, 0xD3CBC9E1u },
+    { 0xFFFFFFFFu, 0x65D0482Du },
+};
+
+static int checks;
+static int failures;
+
+static void check(int ok, const char* what, int a, int b) {
+    checks++;
+    if (!ok) {
+        failures++;
+        if (failures <= 10) {
+            fprintf(stderr, "  failed: %s (%d, %d)\n", what, a, b);
+        }
+    }
+}
+
+static void report(const char* test, int failed_before) {
+    printf("%s: %s\n", test, (failures == failed_before) ? "ok" : "FAILED");
+}
+
+// Start a game on an empty map: only the walls and the paddle are left to hit
+static void empty_field(Paddle* paddle) {
+    uint8_t record[MAPGEN_RECORD_SIZE];
+
+    memset(record, 0, sizeof(record));
+    record[0] = MAP_FORMAT_DENSE;
+    record[1] = (uint8_t)(MAP_WIDTH | (MAP_HEIGHT << 4));
+    event_queue_init();
+    game_init();
+    convert_map(record);
+    view_set(0);
+    paddle->x = 0;
+    paddle->y = PADDLE_VIEW_Y;
+    paddle->width = PADDLE_WIDTH;
+}
+
+// A slow ball turns at a side wall only in the tick it reaches it, from every start in the field
+static void test_wall_sweep(void) {
+    int failed_before = failures;
+    int right_wall = (SCREEN_WIDTH - BALL_SIZE) << 8;
+    Paddle paddle;
+
+    empty_field(&paddle);
+    for (int dir = -1; dir <= 1; dir += 2) {
+        for (int pos = 0; pos <= right_wall; pos += 16) {
+            Ball ball = { (uint8_t)(pos >> 8), 40, (int8_t)(dir * SLOWEST_DX), 0, (uint8_t)pos, 0 };
+            int distance = (dir < 0) ? pos : right_wall - pos;
+            int reaches = distance * BALL_VEL_ONE / SLOWEST_DX < SWEEP_ONE;
+
+            ball_update(&ball, &paddle);
+            check((ball.dx * dir < 0) == reaches, "turned only at a wall", pos, dir);
+        }
+
+        // Across the whole field: the first turn is at the opposite wall
+        Ball ball = { (uint8_t)((dir < 0) ? SCREEN_WIDTH - BALL_SIZE : 0), 40, (int8_t)(dir * SLOWEST_DX), 0, 0, 0 };
+        int ticks = 0;
+        while (ball.dx * dir > 0 && ticks < 1000) {
+            ball_update(&ball, &paddle);
+            ticks++;
+        }
+        int gap = (dir < 0) ? ball.x : SCREEN_WIDTH - BALL_SIZE - ball.x; // Moved back less than a pixel
+        check(ball.dx * dir < 0 && gap <= 1, "crossed the field", ball.x, dir);
+    }
+    report("wall_sweep", failed_before);
+}
+
+// A caught multiball gives three balls flying in different directions, whichever way the ball heads
+static void test_multiball(void) {
+    int failed_before = failures;
+    Paddle paddle;
+
+    for (int angle = 0; angle < BOUNCE_ANGLES; angle++) {
+        for (int down = 0; down <= 1; down++) {
+            Ball ball = { 60, 30, 0, 0, 0, 0 };
+            BallPool balls;
+
+            empty_field(&paddle);
+            ball_aim(&ball, (uint8_t)angle);
+            if (down) {
+                ball.dy = (int8_t)-ball.dy;
+            }
+            ball_pool_init(&balls, &ball);
+            capsules[0].x = paddle.x;
+            capsules[0].y = paddle.y;
+            capsules[0].type = POWERUP_MULTIBALL;
+            capsule_active = 1;
+            powerup_update(&paddle, &balls, 0);
+
+            check(balls.active == 0x7, "three balls in play", balls.active, angle);
+            for (int i = 0; i < 3; i++) {
+                for (int j = i + 1; j < 3; j++) {
+                    check(balls.dx[i] != balls.dx[j] || balls.dy[i] != balls.dy[j], "different velocities", i * 3 + j,
+                          angle * 2 + down);
+                }
+            }
+        }
+    }
+    report("multiball", failed_before);
+}
+
+static uint32_t next_random(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// One tick of the game loop in game.c; returns 1 on game over
+static int game_tick(Paddle* paddle, BallPool* balls, uint8_t touch_pos, uint8_t key, uint32_t now) {
+    Event event;
+
+    if (touch_pos != 0) {
+        paddle_update(paddle, touch_pos);
+    }
+    if (game_state == GAME_STATE_SERVE && key != 0xFF) {
+        ball_launch(balls);
+    }
+    ball_pool_update(balls, paddle, now);
+    powerup_update(paddle, balls, now);
+    while (event_poll(&event)) {
+        if (event.type == EVENT_BLOCK_DESTROYED) {
+            powerup_block_destroyed(event.arg);
+        }
+    }
+    if (check_map_complete()) {
+        load_next_map();
+    }
+    if (get_lives() <= 0) {
+        return 1;
+    }
+    view_update(paddle, balls);
+    return 0;
+}
+
+// Play a game from the menu of game.c: recorded with live input from a noisy player that follows
+// the ball (skill 0 leaves the slider alone), or played back. Returns the final state hash.
+static uint32_t replay_game(ReplayMode mode, int skill) {
+    Paddle paddle = { (SCREEN_WIDTH - PADDLE_WIDTH) / 2, PADDLE_VIEW_Y, PADDLE_WIDTH };
+    Ball ball = { (SCREEN_WIDTH / 2) - BALL_SIZE, PADDLE_VIEW_Y - BALL_SIZE, 0, 0, 0, 0 };
+    BallPool balls;
+    uint32_t rng = REPLAY_SEED;
+    uint32_t now = 0;
+
+    event_queue_init();
+    game_seed = (mode == REPLAY_PLAY) ? 0 : REPLAY_SEED; // Playback takes the seed from the recording
+    game_init();
+    replay_start(mode);
+    ball_aim(&ball, BOUNCE_SERVE_ANGLE);
+    ball_pool_init(&balls, &ball);
+    view_update(&paddle, &balls);
+
+    for (int tick = 0; tick < REPLAY_MAX_TICKS; tick++) {
+        uint8_t touch_pos = 0;
+        uint8_t key = 0xFF;
+        int noise = (int)(next_random(&rng) % 3) - 1; // Slider noise of the TSI
+
+        now += REPLAY_TICK_MS;
+        if (skill && balls.active) {
+            int range = SCREEN_WIDTH - paddle.width;
+            int target = balls.x[__builtin_ctz(balls.active)] + BALL_SIZE / 2 - paddle.width / 2;
+
+            if (target < 0) target = 0;
+            if (target > range) target = range;
+            touch_pos = (uint8_t)(2 + target * 96 / range + noise);
+        }
+        if (game_state == GAME_STATE_SERVE && next_random(&rng) % 64 == 0) {
+            key = 4; // Launched early now and then
+        }
+
+        if (!replay_input(&touch_pos, &key)) {
+            int playing = (replay_mode() == REPLAY_PLAY);
+            replay_finish(replay_state_hash(&paddle, &balls));
+            if (playing) {
+                return replay_state_hash(&paddle, &balls);
+            }
+        }
+        if (game_tick(&paddle, &balls, touch_pos, key, now)) {
+            break;
+        }
+    }
+    uint32_t hash = replay_state_hash(&paddle, &balls);
+    replay_finish(hash);
+    return hash;
+}
+
+// A recorded game plays back to the same state: one that ends before the replay region fills up, and
+// the reference game, which fills it and ends on the hash recorded once
+static void test_replay(const char* image_path) {
+    int failed_before = failures;
+    ReplayHeader recorded;
+
+    replay_game(REPLAY_RECORD, 0);
+    check(replay_available() && !replay_truncated(), "short game recorded whole", replay_available(), replay_truncated());
+    replay_game(REPLAY_PLAY, 0);
+    check(replay_matched(), "short game played back", 0, 0);
+
+    replay_game(REPLAY_RECORD, 1);
+    memcpy(&recorded, replay_image(), sizeof(recorded));
+    check(replay_truncated(), "long game fills the region", recorded.ticks, recorded.size);
+    check(recorded.size > REPLAY_REGION_SIZE - REPLAY_HEADER_SIZE - 32, "region used up", recorded.size, 0);
+    replay_game(REPLAY_PLAY, 1);
+    check(replay_matched(), "long game played back", recorded.ticks, 0);
+    if (recorded.hash != REPLAY_HASH) {
+        fprintf(stderr, "  reference replay: %u ticks, hash 0x%08X\n", (unsigned)recorded.ticks, (unsigned)recorded.hash);
+    }
+    check(recorded.hash == REPLAY_HASH, "reference game ends on the recorded hash", 0, 0);
+
+    if (image_path) {
+        FILE* file = fopen(image_path, "wb");
+        int written = file && fwrite(replay_image(), 1, REPLAY_REGION_SIZE, file) == REPLAY_REGION_SIZE;
+
+        if (file) fclose(file);
+        check(written, "replay image written", 0, 0);
+    }
+    report("replay", failed_before);
+}
+
+// FNV-1a, the same on every host
+static uint32_t digest_bytes(uint32_t hash, const uint8_t* data, int size) {
+    for (int i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// One seed gives the same levels on every build: compared with digests recorded once
+static void test_mapgen(void) {
+    int failed_before = failures;
+    int count = (int)(sizeof(mapgen_golden) / sizeof(mapgen_golden[0]));
+
+    for (int s = 0; s < count; s++) {
+        uint32_t seed = mapgen_golden[s].seed;
+        uint32_t digest = 2166136261u;
+
+        for (int level = 0; level < MAPGEN_LEVELS; level++) {
+            uint8_t record[MAPGEN_RECORD_SIZE];
+            uint8_t again[MAPGEN_RECORD_SIZE];
+            uint8_t difficulty = (uint8_t)(level / MAPGEN_LEVELS_PER_STEP);
+
+            memset(record, 0, sizeof(record));
+            memset(again, 0, sizeof(again));
+            mapgen_build(record, seed, (uint8_t)level, difficulty);
+            mapgen_build(again, seed + 1, (uint8_t)level, difficulty); // Nothing carries over between calls
+            mapgen_build(again, seed, (uint8_t)level, difficulty);
+            check(memcmp(record, again, sizeof(record)) == 0, "same map twice", (int)seed, level);
+
+            convert_map(record);
+            check(!check_map_complete(), "map has a destructible block", (int)seed, level);
+            digest = digest_bytes(digest, record, sizeof(record));
+        }
+        if (digest != mapgen_golden[s].digest) {
+            fprintf(stderr, "  seed 0x%08X: digest 0x%08X\n", (unsigned)seed, (unsigned)digest);
+        }
+        check(digest == mapgen_golden[s].digest, "levels match the recorded ones", (int)seed, 0);
+    }
+    report("mapgen", failed_before);
+}
+
+int main(int argc, char** argv) {
+    test_wall_sweep();
+    test_multiball();
+    test_mapgen();
+    test_replay((argc > 1) ? argv[1] : NULL);
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""Generate 1-bit block collision masks from the block sprites.
+
+The bitmap drawn for each block type is taken from draw_block() in
+game_draw.c and read from Fonts.c, then rendered the way draw_bitmap() does
+(one byte per row, bit 7 first, repeated every 8 columns). The mask is stored
+in the display's page format: one byte per column, bit n set when row n of
+the sprite is lit. Types without a sprite get a solid mask so they can still
+be hit. Types whose mask is solid are also flagged in block_masks_solid so the
+game can skip the per-pixel test for them.
+
+Usage (from the project directory): gen_block_masks.py block_masks.c
+"""
+import re
+import sys
+
+PAGE_HEIGHT = 8
+
+
+def read(path):
+    with open(path, encoding="latin-1") as f:
+        return re.sub(r"//[^\n]*|/\*.*?\*/", "", f.read(), flags=re.S)
+
+
+def read_defines(src):
+    return {name: int(value) for name, value in re.findall(r"#define\s+(\w+)\s+(\d+)\b", src)}
+
+
+def read_block_types(src):
+    body = re.search(r"typedef\s+enum\s*{([^}]*)}\s*BlockType\s*;", src).group(1)
+    return [name.strip() for name in body.split(",") if name.strip()]
+
+
+def read_sprites(src):
+    body = re.search(r"void\s+draw_block\s*\([^)]*\)\s*{(.*?)\n}", src, re.S).group(1)
+    return dict(re.findall(r"case\s+(\w+)\s*:\s*draw_bitmap\s*\(\s*\w+\s*,\s*\w+\s*,\s*(\w+)", body))
+
+
+def read_bitmap(src, name):
+    body = re.search(r"\b%s\s*\[\s*\d*\s*\]\s*=\s*{([^}]*)}" % name, src).group(1)
+    return [int(v, 0) for v in re.findall(r"0[xX][0-9a-fA-F]+|\d+", body)]
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+
+    header = read("arkanoid.h")
+    defines = read_defines(header)
+    width, height = defines["BLOCK_WIDTH"], defines["BLOCK_HEIGHT"]
+    if height > PAGE_HEIGHT:
+        sys.exit("BLOCK_HEIGHT %d does not fit in one display page" % height)
+
+    types = read_block_types(header)
+    if types[-1] != "BLOCK_TYPE_COUNT":
+        sys.exit("arkanoid.h: BlockType must end with BLOCK_TYPE_COUNT")
+    types = types[:-1]
+    sprites = read_sprites(read("game_draw.c"))
+    fonts = read("Fonts.c")
+    solid_column = (1 << height) - 1
+
+    out = ["// Generated by tools/gen_block_masks.py from Fonts.c - do not edit.",
+           '#include "arkanoid.h"',
+           "",
+           "#if BLOCK_WIDTH != %d || BLOCK_HEIGHT != %d" % (width, height),
+           '#error "block_masks.c is out of date, run tools/gen_block_masks.py"',
+           "#endif",
+           "",
+           "const uint8_t block_masks[BLOCK_TYPE_COUNT][BLOCK_WIDTH] = {"]
+    solid = 0
+    for n, name in enumerate(types):
+        sprite = sprites.get(name)
+        if sprite is None:
+            columns = [solid_column] * width
+        else:
+            rows = read_bitmap(fonts, sprite)
+            if len(rows) < height:
+                sys.exit("Fonts.c: %s has %d rows, BLOCK_HEIGHT is %d" % (sprite, len(rows), height))
+            columns = [sum(((rows[r] >> (7 - c % 8)) & 1) << r for r in range(height)) for c in range(width)]
+        if all(col == solid_column for col in columns):
+            solid |= 1 << n
+        out.append("    {%s}%s // %s" % (", ".join("0x%02X" % col for col in columns),
+                                         "," if n + 1 < len(types) else " ", sprite or "no sprite"))
+    out.append("};")
+    out.append("")
+    out.append("const uint16_t block_masks_solid = 0x%04X;" % solid)
+    out.append("")
+
+    with open(sys.argv[1], "w", newline="\r\n") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Generate the paddle bounce direction table.
+
+The paddle is split into ANGLES equal zones. The left half sends the ball up
+and to the left, the right half up and to the right, at MIN_ANGLE (middle of
+the paddle) to MAX_ANGLE (edges) from the vertical. Angles are sampled at the
+middle of each zone, so no entry is ever horizontal or close enough to
+vertical to trap the ball in a column. Each entry is a unit vector in Q7
+(128 = 1.0, clamped to 127 to fit int8_t); the game scales it by the ball
+speed at run time.
+
+Usage: gen_bounce_table.py bounce_table.c
+"""
+import math
+import sys
+
+ANGLES = 16        # Must match BOUNCE_ANGLES in arkanoid.h
+MIN_ANGLE = 15.0   # Degrees from the vertical at the middle of the paddle
+MAX_ANGLE = 60.0   # Degrees from the vertical at the paddle edges
+ONE = 128          # Q7 unit length
+
+
+def q7(v):
+    return max(-127, min(127, int(round(v * ONE))))
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+
+    out = ["// Generated by tools/gen_bounce_table.py - do not edit.",
+           '#include "arkanoid.h"',
+           "",
+           "#if BOUNCE_ANGLES != %d" % ANGLES,
+           '#error "bounce_table.c is out of date, run tools/gen_bounce_table.py"',
+           "#endif",
+           "",
+           "const BounceDir bounce_dirs[BOUNCE_ANGLES] = {"]
+    half = ANGLES // 2
+    for i in range(ANGLES):
+        step = (i - half + 0.5) if i >= half else (half - 1 - i + 0.5)
+        angle = MIN_ANGLE + (MAX_ANGLE - MIN_ANGLE) * step / half
+        if i < half:
+            angle = -angle
+        rad = math.radians(angle)
+        out.append("    {%4d, %4d}%s // %+6.2f deg" % (q7(math.sin(rad)), q7(-math.cos(rad)),
+                                                     "," if i + 1 < ANGLES else " ", angle))
+    out.append("};")
+    out.append("")
+
+    with open(sys.argv[1], "w", newline="\r\n") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
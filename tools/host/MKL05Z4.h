@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for the device header of the KL05Z, for building the display
+ * and game code on a PC (see tools/bench.c). It only declares the register
+ * types and port addresses that oled.c and gpio.h name; the host tools supply
+ * their own gpio_*() and spi_master_write(), so no register is ever touched.
+ */
+#ifndef MKL05Z4_H_
+#define MKL05Z4_H_
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t PCR[32];  // Pin control registers
+} PORT_Type;
+
+typedef struct {
+    volatile uint32_t PDOR, PSOR, PCOR, PTOR, PDIR, PDDR;
+} GPIO_Type;
+
+#define PORTA ((PORT_Type *)0x40049000u)
+#define PORTB ((PORT_Type *)0x4004A000u)
+
+#endif // MKL05Z4_H_
@@ -0,0 +1,299 @@
+/*
+ * Map difficulty analyzer: plays every map many times with the autopilot at
+ * several skill levels and suggests an order from easiest to hardest.
+ *
+ * Per map and skill it reports the mean clear ticks, the mean bounce count
+ * and the life-loss probability (share of runs that lost at least one ball).
+ * A map's difficulty is the mean over the skills of
+ *     life-loss probability + mean clear ticks / mean clear ticks of all maps
+ * so a map that costs lives or takes long to clear ranks late. Runs that hit
+ * the tick limit count as not cleared and add the limit to the clear time.
+ *
+ * Runs differ a lot in length, so they are scheduled by work stealing. The
+ * engine keeps its state in globals, so workers are forked processes. The
+ * job ranges and results live in shared memory: each worker pops jobs from
+ * the front of its own range, and a worker that runs dry takes the back half
+ * of another worker's range. Both sides claim jobs with a compare-and-swap on
+ * the packed range, so no locks are taken.
+ *
+ * Build (from the project directory, Linux or another POSIX host):
+ *   cc -std=c99 -O2 -I. -Itools -o map_difficulty tools/map_difficulty.c tools/sim_game.c \
+ *      arkanoid.c powerup.c event_queue.c autopilot.c mapgen.c maps_packed.c bounce_table.c block_masks.c
+ *
+ * Usage: map_difficulty [-r runs] [-g generated] [-j workers] [-t max_ticks] [-s seed]
+ *   -r  runs per map and skill (default 32)
+ *   -g  generated levels analyzed after the predefined maps (default 15)
+ *   -j  worker processes (default: online CPUs)
+ *   -t  tick limit of a run (default 60000)
+ *   -s  seed of the first run (default 1)
+ */
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS
+
+#include "sim_game.h"
+#include "maps.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define RANGE(head, tail) (((uint64_t)(tail) << 32) | (uint32_t)(head))
+#define RANGE_HEAD(range) ((uint32_t)(range))
+#define RANGE_TAIL(range) ((uint32_t)((range) >> 32))
+
+// Autopilot settings played on every map, best player first
+static const AutopilotConfig skills[] = {
+    { 2, 5 },
+    { AUTOPILOT_DEMO_ERROR, AUTOPILOT_DEMO_STEP },
+    { 12, 2 },
+};
+#define NUM_SKILLS ((int)(sizeof(skills) / sizeof(skills[0])))
+
+typedef struct {
+    int runs;               // Runs per map and skill
+    int maps;               // Maps analyzed, from map 0
+    int workers;            // Worker processes
+    uint32_t max_ticks;     // Tick limit of a run
+    uint32_t seed;          // Seed of the first run
+} Options;
+
+// Shared between the workers: a job range per worker, then a result per job
+typedef struct {
+    uint64_t* ranges;       // Packed [head, tail) of job indices, one per worker
+    SimResult* results;     // Indexed by job
+    uint32_t* steals;       // Successful steals, one counter per worker
+} Shared;
+
+// Job index layout: map-major, then skill, then run
+static void job_params(const Options* opt, uint32_t job, int* map, int* skill) {
+    *map = (int)(job / (uint32_t)(NUM_SKILLS * opt->runs));
+    *skill = (int)(job / (uint32_t)opt->runs % NUM_SKILLS);
+}
+
+// Take the first job of the worker's own range; 0 if it is empty
+static int pop_job(uint64_t* range, uint32_t* job) {
+    uint64_t r = __atomic_load_n(range, __ATOMIC_ACQUIRE);
+
+    while (RANGE_HEAD(r) < RANGE_TAIL(r)) {
+        if (__atomic_compare_exchange_n(range, &r, RANGE(RANGE_HEAD(r) + 1, RANGE_TAIL(r)), 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *job = RANGE_HEAD(r);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Move the back half of another worker's range into the empty own range; 0 if nothing is left anywhere
+static int steal_jobs(const Shared* shared, int workers, int self) {
+    for (int n = 1; n < workers; n++) {
+        uint64_t* victim = &shared->ranges[(self + n) % workers];
+        uint64_t r = __atomic_load_n(victim, __ATOMIC_ACQUIRE);
+
+        while (RANGE_HEAD(r) < RANGE_TAIL(r)) {
+            uint32_t head = RANGE_HEAD(r);
+            uint32_t tail = RANGE_TAIL(r);
+            uint32_t split = tail - (tail - head + 1) / 2; // A single job left is taken whole
+            if (__atomic_compare_exchange_n(victim, &r, RANGE(head, split), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&shared->ranges[self], RANGE(split, tail), __ATOMIC_RELEASE);
+                shared->steals[self]++;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void run_worker(const Options* opt, const Shared* shared, int self) {
+    uint32_t job;
+    int map, skill;
+
+    do {
+        while (pop_job(&shared->ranges[self], &job)) {
+            job_params(opt, job, &map, &skill);
+            sim_play(map, opt->seed + job, &skills[skill], opt->max_ticks, &shared->results[job]);
+        }
+    } while (steal_jobs(shared, opt->workers, self));
+    _exit(0);
+}
+
+// Results of all runs of one map at one skill
+typedef struct {
+    uint32_t runs;
+    uint32_t cleared;
+    uint32_t lost;          // Runs that lost at least one ball
+    uint64_t ticks;         // Clear ticks, the tick limit for runs that did not clear
+    uint64_t bounces;
+} SkillStats;
+
+typedef struct {
+    int map;
+    double difficulty;
+} Ranked;
+
+static int compare_ranked(const void* a, const void* b) {
+    double d = ((const Ranked*)a)->difficulty - ((const Ranked*)b)->difficulty;
+    return (d > 0) - (d < 0);
+}
+
+static double seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const Options* opt, const Shared* shared, double elapsed) {
+    uint32_t jobs = (uint32_t)(opt->maps * NUM_SKILLS * opt->runs);
+    SkillStats* stats = calloc((size_t)opt->maps * NUM_SKILLS, sizeof(SkillStats));
+    Ranked* ranked = calloc((size_t)opt->maps, sizeof(Ranked));
+    double mean_ticks[NUM_SKILLS] = { 0 };
+    uint64_t steals = 0;
+
+    if (!stats || !ranked) {
+        perror("map_difficulty");
+        exit(1);
+    }
+    for (uint32_t job = 0; job < jobs; job++) {
+        const SimResult* r = &shared->results[job];
+        int map, skill;
+        if (r->ticks == 0) {
+            fprintf(stderr, "map_difficulty: run %u was never played\n", job); // Every run plays at least one tick
+            exit(1);
+        }
+        job_params(opt, job, &map, &skill);
+        SkillStats* s = &stats[map * NUM_SKILLS + skill];
+        s->runs++;
+        s->cleared += r->cleared;
+        s->lost += (r->lives_lost > 0);
+        s->ticks += r->cleared ? r->ticks : opt->max_ticks;
+        s->bounces += r->bounces;
+    }
+    for (int skill = 0; skill < NUM_SKILLS; skill++) {
+        for (int map = 0; map < opt->maps; map++) {
+            mean_ticks[skill] += (double)stats[map * NUM_SKILLS + skill].ticks / opt->runs / opt->maps;
+        }
+    }
+    for (int w = 0; w < opt->workers; w++) {
+        steals += shared->steals[w];
+    }
+
+    printf("{\n");
+    printf("  \"workers\": %d,\n", opt->workers);
+    printf("  \"runs\": %u,\n", jobs);
+    printf("  \"steals\": %llu,\n", (unsigned long long)steals);
+    printf("  \"seconds\": %.3f,\n", elapsed);
+    printf("  \"skills\": [");
+    for (int skill = 0; skill < NUM_SKILLS; skill++) {
+        printf("{\"max_error\": %u, \"max_step\": %u}%s", skills[skill].max_error, skills[skill].max_step,
+               (skill + 1 < NUM_SKILLS) ? ", " : "");
+    }
+    printf("],\n");
+    printf("  \"maps\": [\n");
+    for (int map = 0; map < opt->maps; map++) {
+        double difficulty = 0;
+        printf("    {\"map\": %d, \"generated\": %s, \"skills\": [", map, (map >= NUM_MAPS) ? "true" : "false");
+        for (int skill = 0; skill < NUM_SKILLS; skill++) {
+            const SkillStats* s = &stats[map * NUM_SKILLS + skill];
+            double loss = (double)s->lost / s->runs;
+            double ticks = (double)s->ticks / s->runs;
+            difficulty += (loss + (mean_ticks[skill] > 0 ? ticks / mean_ticks[skill] : 0)) / NUM_SKILLS;
+            printf("{\"cleared\": %u, \"clear_ticks_mean\": %.1f, \"bounces_mean\": %.1f, \"life_loss_probability\": %.3f}%s",
+                   s->cleared, ticks, (double)s->bounces / s->runs, loss, (skill + 1 < NUM_SKILLS) ? ", " : "");
+        }
+        printf("], \"difficulty\": %.3f}%s\n", difficulty, (map + 1 < opt->maps) ? "," : "");
+        ranked[map].map = map;
+        ranked[map].difficulty = difficulty;
+    }
+    printf("  ],\n");
+
+    qsort(ranked, (size_t)opt->maps, sizeof(Ranked), compare_ranked);
+    printf("  \"suggested_order\": [");
+    for (int i = 0; i < opt->maps; i++) {
+        printf("%d%s", ranked[i].map, (i + 1 < opt->maps) ? ", " : "");
+    }
+    printf("]\n");
+    printf("}\n");
+    free(stats);
+    free(ranked);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [-r runs] [-g generated] [-j workers] [-t max_ticks] [-s seed]\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    Options opt = { 32, NUM_MAPS + 15, 0, 60000, 1 };
+    int c;
+
+    while ((c = getopt(argc, argv, "r:g:j:t:s:")) != -1) {
+        switch (c) {
+            case 'r': opt.runs = atoi(optarg); break;
+            case 'g': opt.maps = NUM_MAPS + atoi(optarg); break;
+            case 'j': opt.workers = atoi(optarg); break;
+            case 't': opt.max_ticks = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 's': opt.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        opt.workers = (cpus > 0) ? (int)cpus : 1;
+    }
+    if (opt.runs <= 0 || opt.maps < NUM_MAPS || opt.maps > NUM_LEVELS) {
+        fprintf(stderr, "Runs must be positive and generated levels within 0..%d\n", NUM_LEVELS - NUM_MAPS);
+        return 2;
+    }
+
+    uint32_t jobs = (uint32_t)(opt.maps * NUM_SKILLS * opt.runs);
+    if ((uint32_t)opt.workers > jobs) {
+        opt.workers = (int)jobs;
+    }
+
+    // One shared mapping: ranges, then results, then steal counters
+    size_t ranges_size = (size_t)opt.workers * sizeof(uint64_t);
+    size_t results_size = (size_t)jobs * sizeof(SimResult);
+    size_t size = ranges_size + results_size + (size_t)opt.workers * sizeof(uint32_t);
+    uint8_t* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    Shared shared = { (uint64_t*)memory, (SimResult*)(memory + ranges_size),
+                      (uint32_t*)(memory + ranges_size + results_size) };
+
+    // Equal contiguous ranges to start with; stealing evens out the run lengths
+    for (int w = 0; w < opt.workers; w++) {
+        shared.ranges[w] = RANGE((uint64_t)jobs * w / opt.workers, (uint64_t)jobs * (w + 1) / opt.workers);
+    }
+
+    double start = seconds();
+    for (int w = 0; w < opt.workers; w++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            run_worker(&opt, &shared, w);
+        }
+    }
+
+    int failed = 0;
+    int status;
+    while (wait(&status) > 0) {
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    if (failed) {
+        fprintf(stderr, "map_difficulty: a worker failed\n");
+        return 1;
+    }
+
+    report(&opt, &shared, seconds() - start);
+    munmap(memory, size);
+    return 0;
+}
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Pack the readable level table from maps.c into per-map records.
+
+A map in maps.c may use fewer rows or columns than the MAP_HEIGHT x MAP_WIDTH
+capacity; missing cells are empty. Each map is trimmed to the bounding box of
+its blocks (anchored at the top left cell) and stored in whichever of two
+formats is smaller:
+
+  dense:  MAP_FORMAT_DENSE, width | height << 4, then width * height cells
+          at 4 bits each, two per byte, low nibble first, row by row
+  sparse: MAP_FORMAT_SPARSE, width | height << 4, block count, then one
+          (cell index, type) byte pair per block, cell index as BLOCK_INDEX
+
+Usage: pack_maps.py maps.c maps_packed.c
+"""
+import os
+import re
+import sys
+
+FORMAT_DENSE = 0
+FORMAT_SPARSE = 1
+STEEL = 7          # BLOCK_TYPE_STEEL in arkanoid.h, the indestructible block
+
+
+def read_defines(path):
+    with open(path, encoding="latin-1") as f:
+        src = f.read()
+    return {name: int(value) for name, value in re.findall(r"#define\s+(\w+)\s+(\d+)\b", src)}
+
+
+def read_maps(path):
+    with open(path, encoding="latin-1") as f:
+        src = f.read()
+    # Strip comments, then walk the braces inside the initializer of maps[]
+    src = re.sub(r"//[^\n]*|/\*.*?\*/", "", src, flags=re.S)
+    body = src[src.index("=", src.index("maps[")) + 1:]
+
+    maps, depth = [], 0
+    for token in re.findall(r"[{}]|\d+", body):
+        if token == "{":
+            depth += 1
+            if depth == 2:
+                maps.append([])
+            elif depth == 3:
+                maps[-1].append([])
+        elif token == "}":
+            depth -= 1
+            if depth == 0:
+                break
+        elif depth == 3:
+            maps[-1][-1].append(int(token))
+        else:
+            sys.exit("maps.c: each map must be a list of rows in braces")
+    return maps
+
+
+def check(n, rows, width, height):
+    if len(rows) > height:
+        sys.exit("maps.c: map %d has %d rows, MAP_HEIGHT is %d" % (n, len(rows), height))
+    for row in rows:
+        if len(row) > width:
+            sys.exit("maps.c: map %d has a row of %d cells, MAP_WIDTH is %d" % (n, len(row), width))
+        for v in row:
+            if v > 15:
+                sys.exit("maps.c: block type %d does not fit in 4 bits" % v)
+
+
+def encode(rows, stride):
+    blocks = [(r, c, v) for r, row in enumerate(rows) for c, v in enumerate(row) if v]
+    if not blocks:
+        return None
+    width = max(c for _, c, _ in blocks) + 1
+    height = max(r for r, _, _ in blocks) + 1
+    dims = width | (height << 4)
+
+    cells = [0] * (width * height)
+    for r, c, v in blocks:
+        cells[r * width + c] = v
+    if len(cells) % 2:
+        cells.append(0)
+    dense = [FORMAT_DENSE, dims] + [cells[i] | (cells[i + 1] << 4) for i in range(0, len(cells), 2)]
+
+    sparse = [FORMAT_SPARSE, dims, len(blocks)]
+    for r, c, v in blocks:
+        sparse += [r * stride + c, v]
+
+    if len(sparse) < len(dense):
+        return "sparse", width, height, sparse
+    return "dense", width, height, dense
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    defines = read_defines(os.path.join(os.path.dirname(sys.argv[1]) or ".", "maps.h"))
+    width, height = defines["MAP_WIDTH"], defines["MAP_HEIGHT"]
+    if width > 15 or height > 15:
+        sys.exit("maps.h: MAP_WIDTH %d x MAP_HEIGHT %d, records store each in 4 bits (up to 15)" % (width, height))
+    maps = read_maps(sys.argv[1])
+    if len(maps) != defines["NUM_MAPS"]:
+        sys.exit("maps.c: %d maps, NUM_MAPS is %d" % (len(maps), defines["NUM_MAPS"]))
+
+    out = ["// Generated by tools/pack_maps.py from maps.c - do not edit.",
+           '#include "maps.h"',
+           "",
+           "const uint8_t maps_data[] = {"]
+    offsets, offset = [], 0
+    for n, rows in enumerate(maps):
+        check(n, rows, width, height)
+        record = encode(rows, width)
+        if record is None:
+            sys.exit("maps.c: map %d has no blocks" % n)
+        if all(v in (0, STEEL) for row in rows for v in row):
+            sys.exit("maps.c: map %d has only steel blocks and can never be cleared" % n)
+        kind, w, h, data = record
+        out.append("    // Map %d: %dx%d %s" % (n, w, h, kind))
+        out.append("    %s," % ", ".join("0x%02X" % b for b in data))
+        offsets.append(offset)
+        offset += len(data)
+    out.append("};")
+    out.append("")
+    out.append("const uint16_t maps_offset[NUM_MAPS] = {")
+    for i in range(0, len(offsets), 10):
+        out.append("    %s%s" % (", ".join("%d" % o for o in offsets[i:i + 10]),
+                                 "," if i + 10 < len(offsets) else ""))
+    out.append("};")
+    out.append("")
+
+    with open(sys.argv[2], "w", newline="\r\n") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
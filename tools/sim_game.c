@@ -0,0 +1,61 @@
+#include "sim_game.h"
+#include "arkanoid.h"
+#include "powerup.h"
+#include "event_queue.h"
+#include <string.h>
+
+void sim_play(int map, uint32_t seed, const AutopilotConfig* config, uint32_t max_ticks, SimResult* result) {
+    Paddle paddle = { (SCREEN_WIDTH - PADDLE_WIDTH) / 2, PADDLE_VIEW_Y, PADDLE_WIDTH };
+    Ball ball = { (SCREEN_WIDTH / 2) - BALL_SIZE, PADDLE_VIEW_Y - BALL_SIZE, 0, 0, 0, 0 };
+    BallPool balls;
+    int8_t last_dy[MAX_BALLS] = { 0 };
+    uint32_t now = 0;
+    int done = 0;
+    Event event;
+
+    event_queue_init();
+    game_seed = seed;
+    game_init();
+    if (map != 0) {
+        current_map = map;
+        load_next_map();
+    }
+    autopilot_init(config, seed);
+    ball_aim(&ball, BOUNCE_SERVE_ANGLE);
+    ball_pool_init(&balls, &ball);
+    view_update(&paddle, &balls);
+
+    memset(result, 0, sizeof(*result));
+    result->map = (uint16_t)map;
+    while (!done && result->ticks < max_ticks) {
+        now += SIM_TICK_MS;
+        result->ticks++;
+        paddle_update(&paddle, autopilot_input(&balls, &paddle));
+        ball_pool_update(&balls, &paddle, now);
+        powerup_update(&paddle, &balls, now);
+
+        for (uint8_t i = 0; i < MAX_BALLS; i++) {
+            int8_t dy = (balls.active & BALL_BIT(i)) ? balls.dy[i] : 0;
+            if (last_dy[i] > 0 && dy < 0) {
+                result->bounces++;
+            }
+            last_dy[i] = dy;
+        }
+
+        while (event_poll(&event)) {
+            switch (event.type) {
+                case EVENT_BLOCK_DESTROYED:
+                    powerup_block_destroyed(event.arg);
+                    break;
+                case EVENT_LIFE_LOST:
+                    result->lives_lost++;
+                    break;
+                default:
+                    break;
+            }
+        }
+        result->cleared = (uint8_t)check_map_complete(); // The state decides, as in game.c
+        done = result->cleared || get_lives() <= 0;
+        view_update(&paddle, &balls);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef SIM_GAME_H
+#define SIM_GAME_H
+
+#include <stdint.h>
+#include "autopilot.h"
+
+/**
+ * @brief Headless game parameters for the host tools.
+ */
+#define SIM_TICK_MS 16              ///< Game time per tick, about one frame of the board's game loop.
+
+/**
+ * @brief Outcome of one headless game.
+ */
+typedef struct {
+    uint16_t map;                   ///< Map the game was played on.
+    uint8_t cleared;                ///< The map was cleared.
+    uint8_t lives_lost;             ///< Balls drained before the end.
+    uint32_t ticks;                 ///< Ticks played.
+    uint32_t bounces;               ///< Times a ball turned from falling to rising.
+} SimResult;
+
+/**
+ * @brief Plays one map with the autopilot on the engine globals.
+ *
+ * Starts like start_game() on the given map and runs the game loop of
+ * game.c without drawing, until the map is cleared, the last life is lost
+ * or the tick limit is reached.
+ *
+ * @param map Map to play (from NUM_MAPS on, generated levels), below NUM_LEVELS.
+ * @param seed Game and autopilot seed.
+ * @param config Autopilot error model.
+ * @param max_ticks Tick limit.
+ * @param result Filled with the outcome.
+ */
+void sim_play(int map, uint32_t seed, const AutopilotConfig* config, uint32_t max_ticks, SimResult* result);
+
+#endif // SIM_GAME_H
@@ -0,0 +1,369 @@
+#include "vec_env.h"
+#include "event_queue.h"
+#include "replay.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define QUIET_FOREVER 0x40000000u // quiet_until ahead of now for a lane with no timer running
+#define BALL_TICK_MOVE (SWEEP_ONE / BALL_VEL_ONE) // Position change per velocity unit over a whole tick, in 1/256 pixel
+
+int vec_env_init(VecEnv* env, int lanes, int observe) {
+    size_t n = (size_t)lanes;
+    size_t balls = n * MAX_BALLS;
+
+    memset(env, 0, sizeof(*env));
+    env->lanes = lanes;
+    env->games = calloc(n, sizeof(GameContext));
+    env->powerups = calloc(n, sizeof(PowerupContext));
+    env->ball_x = calloc(balls, 1);
+    env->ball_y = calloc(balls, 1);
+    env->ball_dx = calloc(balls, 1);
+    env->ball_dy = calloc(balls, 1);
+    env->ball_fx = calloc(balls, 1);
+    env->ball_fy = calloc(balls, 1);
+    env->ball_active = calloc(n, sizeof(uint16_t));
+    env->paddle_x = calloc(n, 1);
+    env->paddle_y = calloc(n, 1);
+    env->paddle_width = calloc(n, 1);
+    env->block_rows = calloc(n * MAP_HEIGHT, sizeof(uint16_t));
+    env->block_bottom = calloc(n, 1);
+    env->view_top = calloc(n, 1);
+    env->quiet_until = calloc(n, sizeof(uint32_t));
+    env->wide = calloc(n, 1);
+    env->next_paddle_x = calloc(n, 1);
+    env->reward = calloc(n, sizeof(int32_t));
+    env->done = calloc(n, 1);
+    env->ticks = calloc(n, sizeof(uint32_t));
+    env->obs = observe ? calloc(n, VEC_ENV_OBS_SIZE) : NULL;
+
+    if (!env->games || !env->powerups || !env->ball_x || !env->ball_y || !env->ball_dx || !env->ball_dy ||
+        !env->ball_fx || !env->ball_fy || !env->ball_active || !env->paddle_x || !env->paddle_y ||
+        !env->paddle_width || !env->block_rows || !env->block_bottom || !env->view_top || !env->quiet_until ||
+        !env->wide || !env->next_paddle_x || !env->reward || !env->done || !env->ticks || (observe && !env->obs)) {
+        vec_env_free(env);
+        return 0;
+    }
+    memset(env->done, 1, n); // Nothing to step before a reset
+    return 1;
+}
+
+void vec_env_free(VecEnv* env) {
+    free(env->games);
+    free(env->powerups);
+    free(env->ball_x);
+    free(env->ball_y);
+    free(env->ball_dx);
+    free(env->ball_dy);
+    free(env->ball_fx);
+    free(env->ball_fy);
+    free(env->ball_active);
+    free(env->paddle_x);
+    free(env->paddle_y);
+    free(env->paddle_width);
+    free(env->block_rows);
+    free(env->block_bottom);
+    free(env->view_top);
+    free(env->quiet_until);
+    free(env->wide);
+    free(env->next_paddle_x);
+    free(env->reward);
+    free(env->done);
+    free(env->ticks);
+    free(env->obs);
+    memset(env, 0, sizeof(*env));
+}
+
+void vec_env_balls(const VecEnv* env, int lane, BallPool* pool) {
+    for (int slot = 0; slot < MAX_BALLS; slot++) {
+        int i = VEC_ENV_BALL(env, slot, lane);
+        pool->x[slot] = env->ball_x[i];
+        pool->y[slot] = env->ball_y[i];
+        pool->dx[slot] = env->ball_dx[i];
+        pool->dy[slot] = env->ball_dy[i];
+        pool->fx[slot] = env->ball_fx[i];
+        pool->fy[slot] = env->ball_fy[i];
+    }
+    pool->active = env->ball_active[lane];
+}
+
+// Keep a lane's state after running it on the engine
+static void lane_save(VecEnv* env, int lane, const Paddle* paddle, const BallPool* pool) {
+    GameContext* game = &env->games[lane];
+
+    game_context_save(game);
+    powerup_context_save(&env->powerups[lane]);
+    for (int slot = 0; slot < MAX_BALLS; slot++) {
+        int i = VEC_ENV_BALL(env, slot, lane);
+        env->ball_x[i] = pool->x[slot];
+        env->ball_y[i] = pool->y[slot];
+        env->ball_dx[i] = pool->dx[slot];
+        env->ball_dy[i] = pool->dy[slot];
+        env->ball_fx[i] = pool->fx[slot];
+        env->ball_fy[i] = pool->fy[slot];
+    }
+    env->ball_active[lane] = pool->active;
+    env->paddle_x[lane] = paddle->x;
+    env->paddle_y[lane] = paddle->y;
+    env->paddle_width[lane] = paddle->width;
+
+    env->block_bottom[lane] = 0;
+    for (int row = 0; row < MAP_HEIGHT; row++) {
+        env->block_rows[VEC_ENV_ROW(env, row, lane)] = game->rows[row];
+        if (game->rows[row]) {
+            env->block_bottom[lane] = BLOCK_Y(row) + BLOCK_HEIGHT;
+        }
+    }
+    env->view_top[lane] = game->view_top;
+}
+
+// Put a lane's state on the engine
+static void lane_load(const VecEnv* env, int lane, Paddle* paddle, BallPool* pool) {
+    game_context_load(&env->games[lane]);
+    powerup_context_load(&env->powerups[lane]);
+    vec_env_balls(env, lane, pool);
+    paddle->x = env->paddle_x[lane];
+    paddle->y = env->paddle_y[lane];
+    paddle->width = env->paddle_width[lane];
+}
+
+// Mark the observation cells covered by a box given in screen pixels
+static void observe_box(uint8_t* obs, int x, int y, int w, int h, uint8_t value) {
+    int x1 = x + w;
+    int y1 = y + h;
+
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 > SCREEN_WIDTH) x1 = SCREEN_WIDTH;
+    if (y1 > SCREEN_HEIGHT) y1 = SCREEN_HEIGHT;
+    if (x >= x1 || y >= y1) {
+        return;
+    }
+
+    for (int cy = y / VEC_ENV_OBS_SCALE; cy <= (y1 - 1) / VEC_ENV_OBS_SCALE; cy++) {
+        memset(&obs[cy * VEC_ENV_OBS_WIDTH + x / VEC_ENV_OBS_SCALE], value,
+               (size_t)((x1 - 1) / VEC_ENV_OBS_SCALE - x / VEC_ENV_OBS_SCALE + 1));
+    }
+}
+
+// Draw a lane's screen at observation resolution
+static void observe_lane(const VecEnv* env, int lane) {
+    uint8_t* obs = &env->obs[(size_t)lane * VEC_ENV_OBS_SIZE];
+    const PowerupContext* powerup = &env->powerups[lane];
+    int top = env->view_top[lane];
+    int first_row = (top + BLOCK_PITCH_Y - 1) / BLOCK_PITCH_Y; // Rows under the HUD are out of play
+
+    memset(obs, VEC_ENV_OBS_EMPTY, VEC_ENV_OBS_SIZE);
+    for (int row = first_row; row < MAP_HEIGHT; row++) {
+        for (uint16_t bits = env->block_rows[VEC_ENV_ROW(env, row, lane)]; bits; bits &= bits - 1) {
+            observe_box(obs, BLOCK_X(BLOCK_ROW_FIRST(bits)), BLOCK_Y(row) - top, BLOCK_WIDTH, BLOCK_HEIGHT, VEC_ENV_OBS_BLOCK);
+        }
+    }
+    for (uint8_t bits = powerup->active; bits; bits &= bits - 1) {
+        const Capsule* capsule = &powerup->capsules[__builtin_ctz(bits)];
+        observe_box(obs, capsule->x, capsule->y - top, CAPSULE_WIDTH, CAPSULE_HEIGHT, VEC_ENV_OBS_CAPSULE);
+    }
+    observe_box(obs, env->paddle_x[lane], env->paddle_y[lane] - top, env->paddle_width[lane], PADDLE_HEIGHT, VEC_ENV_OBS_PADDLE);
+    for (uint16_t bits = env->ball_active[lane]; bits; bits &= bits - 1) {
+        int i = VEC_ENV_BALL(env, __builtin_ctz(bits), lane);
+        observe_box(obs, env->ball_x[i], env->ball_y[i] - top, BALL_SIZE, BALL_SIZE, VEC_ENV_OBS_BALL);
+    }
+}
+
+void vec_env_reset(VecEnv* env, int lane, int map, uint32_t seed) {
+    Paddle paddle = { (SCREEN_WIDTH - PADDLE_WIDTH) / 2, PADDLE_VIEW_Y, PADDLE_WIDTH };
+    Ball ball = { (SCREEN_WIDTH / 2) - BALL_SIZE, PADDLE_VIEW_Y - BALL_SIZE, 0, 0, 0, 0 };
+    BallPool pool;
+
+    // Same start as start_game(), on the given map
+    event_queue_init();
+    game_seed = seed;
+    game_init();
+    if (map != 0) {
+        current_map = map;
+        load_next_map();
+    }
+    ball_aim(&ball, BOUNCE_SERVE_ANGLE);
+    ball_pool_init(&pool, &ball);
+    view_update(&paddle, &pool);
+
+    lane_save(env, lane, &paddle, &pool);
+    env->quiet_until[lane] = env->now; // The first step runs on the engine, which works out the rest
+    env->reward[lane] = 0;
+    env->done[lane] = 0;
+    env->ticks[lane] = 0;
+    if (env->obs) {
+        observe_lane(env, lane);
+    }
+}
+
+// Clears the lanes of wide[] whose ball in one slot could touch a wall, the paddle, a block or the
+// bottom edge this tick. Every test is a bitwise one, so the loop has no branches to stop vectorization.
+static void mark_wide_slot(int n, int slot, uint8_t* restrict wide, const uint8_t* restrict bx,
+                           const uint8_t* restrict by, const uint8_t* restrict bfx, const uint8_t* restrict bfy,
+                           const int8_t* restrict bdx, const int8_t* restrict bdy, const uint16_t* restrict ball_active,
+                           const uint8_t* restrict paddle_x, const uint8_t* restrict paddle_y,
+                           const uint8_t* restrict paddle_width, const uint8_t* restrict view_top,
+                           const uint8_t* restrict block_bottom) {
+    for (int lane = 0; lane < n; lane++) {
+        int32_t x = ((int32_t)bx[lane] << 8) | bfx[lane];
+        int32_t y = ((int32_t)by[lane] << 8) | bfy[lane];
+        int32_t x_end = x + bdx[lane] * BALL_TICK_MOVE;
+        int32_t y_end = y + bdy[lane] * BALL_TICK_MOVE;
+        int32_t top = view_top[lane];
+        int32_t left = (paddle_x[lane] - BALL_SIZE - 1) << 8;
+        int32_t right = (paddle_x[lane] + paddle_width[lane] + 1) << 8;
+        int32_t above = (paddle_y[lane] - 1 - BALL_SIZE - 1) << 8;
+        int32_t below = (paddle_y[lane] + PADDLE_HEIGHT + 1) << 8;
+        int32_t bottom = block_bottom[lane] << 8;
+
+        // Both ends of the move are tested rather than its min and max: SSE2 has no 32-bit min
+        int walls = (x_end >= 0) & (x_end <= ((SCREEN_WIDTH - BALL_SIZE) << 8)) & (y_end >= ((top + PLAYFIELD_TOP) << 8));
+        int paddle = ((x < left) & (x_end < left)) | ((x > right) & (x_end > right)) |
+                     ((y < above) & (y_end < above)) | ((y > below) & (y_end > below));
+        int blocks = (y >= bottom) & (y_end >= bottom);
+        int screen = y_end < ((top + SCREEN_HEIGHT + 1) << 8);
+        int active = (ball_active[lane] >> slot) & 1;
+
+        wide[lane] &= (uint8_t)~(active & ~(walls & paddle & blocks & screen));
+    }
+}
+
+// Lane-wide pass, part 1: the paddles after the actions, and the lanes whose tick cannot touch anything.
+// A ball qualifies when over the whole tick it stays within the side walls and below the top wall, at
+// least a pixel clear of the paddle on one axis (so rounding in the engine's sweep cannot reach it),
+// entirely below the lowest block row (the engine's own broadphase early-out) and on the screen.
+static void mark_wide(VecEnv* env, const uint8_t* restrict actions) {
+    const int n = env->lanes;
+    const uint32_t now = env->now;
+    uint8_t* restrict wide = env->wide;
+    uint8_t* restrict next_x = env->next_paddle_x;
+    const uint8_t* restrict paddle_x = env->paddle_x;
+    const uint8_t* restrict paddle_width = env->paddle_width;
+    const uint8_t* restrict done = env->done;
+    const uint32_t* restrict quiet_until = env->quiet_until;
+
+    for (int lane = 0; lane < n; lane++) {
+        int action = actions[lane];
+        uint8_t moved = (uint8_t)(action * (SCREEN_WIDTH - paddle_width[lane]) / 100); // As paddle_update()
+        uint8_t keep = (uint8_t)((action != 0) - 1); // 0xFF when the action leaves the paddle where it is
+
+        next_x[lane] = (uint8_t)((paddle_x[lane] & keep) | (moved & ~keep));
+        wide[lane] = (uint8_t)((done[lane] == 0) & ((int32_t)(quiet_until[lane] - now) > 0));
+    }
+    for (int slot = 0; slot < MAX_BALLS; slot++) {
+        mark_wide_slot(n, slot, wide, &env->ball_x[slot * n], &env->ball_y[slot * n], &env->ball_fx[slot * n],
+                       &env->ball_fy[slot * n], &env->ball_dx[slot * n], &env->ball_dy[slot * n], env->ball_active,
+                       next_x, env->paddle_y, paddle_width, env->view_top, env->block_bottom);
+    }
+}
+
+// Moves the balls in one slot of the marked lanes a tick on, blending so that the loop has no branches
+static void step_wide_slot(int n, int slot, const uint8_t* restrict wide, const uint16_t* restrict ball_active,
+                           uint8_t* restrict bx, uint8_t* restrict by, uint8_t* restrict bfx, uint8_t* restrict bfy,
+                           const int8_t* restrict bdx, const int8_t* restrict bdy) {
+    for (int lane = 0; lane < n; lane++) {
+        int32_t x = (((int32_t)bx[lane] << 8) | bfx[lane]) + bdx[lane] * BALL_TICK_MOVE;
+        int32_t y = (((int32_t)by[lane] << 8) | bfy[lane]) + bdy[lane] * BALL_TICK_MOVE;
+        uint8_t keep = (uint8_t)(((wide[lane] & (ball_active[lane] >> slot)) & 1) - 1); // 0xFF unless the ball moves
+
+        bx[lane] = (uint8_t)((bx[lane] & keep) | ((x >> 8) & ~keep));
+        bfx[lane] = (uint8_t)((bfx[lane] & keep) | (x & ~keep));
+        by[lane] = (uint8_t)((by[lane] & keep) | ((y >> 8) & ~keep));
+        bfy[lane] = (uint8_t)((bfy[lane] & keep) | (y & ~keep));
+    }
+}
+
+// Lane-wide pass, part 2: move the paddles and balls of the marked lanes
+static void step_wide(VecEnv* env) {
+    const int n = env->lanes;
+    const uint8_t* restrict wide = env->wide;
+    uint8_t* restrict paddle_x = env->paddle_x;
+    const uint8_t* restrict next_x = env->next_paddle_x;
+    uint32_t* restrict ticks = env->ticks;
+
+    for (int slot = 0; slot < MAX_BALLS; slot++) {
+        step_wide_slot(n, slot, wide, env->ball_active, &env->ball_x[slot * n], &env->ball_y[slot * n],
+                       &env->ball_fx[slot * n], &env->ball_fy[slot * n], &env->ball_dx[slot * n],
+                       &env->ball_dy[slot * n]);
+    }
+    for (int lane = 0; lane < n; lane++) {
+        uint8_t keep = (uint8_t)(wide[lane] - 1);
+
+        paddle_x[lane] = (uint8_t)((paddle_x[lane] & keep) | (next_x[lane] & ~keep));
+        ticks[lane] += wide[lane];
+    }
+
+    // What powerup_update() does with nothing falling and no timer due
+    for (int lane = 0; lane < n; lane++) {
+        if (wide[lane]) {
+            PowerupContext* powerup = &env->powerups[lane];
+            if (++powerup->fall_ticks >= CAPSULE_FALL_PERIOD) {
+                powerup->fall_ticks = 0;
+            }
+            env->wide_steps++;
+        }
+    }
+}
+
+// One tick of the game loop in game.c on the engine, without drawing
+static void step_engine(VecEnv* env, int lane, uint8_t action) {
+    const PowerupContext* powerup = &env->powerups[lane];
+    Paddle paddle;
+    BallPool pool;
+    Event event;
+
+    lane_load(env, lane, &paddle, &pool);
+    int score = current_score;
+    if (action != 0) {
+        paddle_update(&paddle, action);
+    }
+    ball_pool_update(&pool, &paddle, env->now);
+    powerup_update(&paddle, &pool, env->now);
+    while (event_poll(&event)) {
+        if (event.type == EVENT_BLOCK_DESTROYED) {
+            powerup_block_destroyed(event.arg);
+        }
+    }
+    env->done[lane] = check_map_complete() || get_lives() <= 0; // The state decides, as in game.c
+    uint8_t top = view_top;
+    view_update(&paddle, &pool);
+    int settled = (view_top == top); // An unchanged view is at its target, and stays there until blocks change
+
+    env->reward[lane] = current_score - score;
+    env->ticks[lane]++;
+    lane_save(env, lane, &paddle, &pool);
+
+    // The next steps may be lane-wide while only the balls and the capsule clock move
+    if (game_state == GAME_STATE_PLAY && settled && powerup->active == 0 && !powerup->multiball_pending) {
+        env->quiet_until[lane] = powerup->expanding ? powerup->expand_end : env->now + QUIET_FOREVER;
+    } else {
+        env->quiet_until[lane] = env->now;
+    }
+}
+
+void vec_env_step(VecEnv* env, const uint8_t* actions) {
+    env->now += VEC_ENV_TICK_MS;
+    memset(env->reward, 0, (size_t)env->lanes * sizeof(env->reward[0]));
+
+    mark_wide(env, actions);
+    step_wide(env);
+    for (int lane = 0; lane < env->lanes; lane++) {
+        if (!env->done[lane] && !env->wide[lane]) {
+            step_engine(env, lane, actions[lane]);
+        }
+    }
+
+    if (env->obs) {
+        for (int lane = 0; lane < env->lanes; lane++) {
+            observe_lane(env, lane);
+        }
+    }
+}
+
+uint32_t vec_env_hash(const VecEnv* env, int lane) {
+    Paddle paddle;
+    BallPool pool;
+
+    lane_load(env, lane, &paddle, &pool);
+    return replay_state_hash(&paddle, &pool);
+}
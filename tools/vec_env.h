@@ -0,0 +1,139 @@
+#ifndef VEC_ENV_H
+#define VEC_ENV_H
+
+#include <stdint.h>
+#include "arkanoid.h"
+#include "powerup.h"
+
+/**
+ * @brief Lockstep environment parameters.
+ *
+ * A VecEnv steps a batch of independent games ("lanes") one tick at a time,
+ * for training and evaluating paddle controllers on a host. Host builds only
+ * (ARKANOID_HOST).
+ *
+ * A step has two passes. The lane-wide pass works on the structure-of-arrays
+ * state below in loops over all lanes that the compiler vectorizes (build
+ * with -O3): it moves the paddles, and moves the balls of every lane whose
+ * tick cannot touch anything, that is every ball clear of the walls, the
+ * paddle and the lowest block row for the whole tick, with no capsule, timer
+ * or view scroll due. In vec_env_bench that is 42-45% of lane steps, while
+ * balls fly between the blocks and the paddle (see the table there). Its
+ * tests are conservative, so it does exactly what the engine would. The
+ * other lanes run the firmware engine unchanged, their state swapped in from
+ * the arrays, a GameContext and a PowerupContext.
+ */
+#define VEC_ENV_TICK_MS 16                                      ///< Game time per step in ms.
+#define VEC_ENV_OBS_SCALE 4                                     ///< Screen pixels per observation cell on each axis.
+#define VEC_ENV_OBS_WIDTH (SCREEN_WIDTH / VEC_ENV_OBS_SCALE)    ///< Observation width in cells.
+#define VEC_ENV_OBS_HEIGHT (SCREEN_HEIGHT / VEC_ENV_OBS_SCALE)  ///< Observation height in cells.
+#define VEC_ENV_OBS_SIZE (VEC_ENV_OBS_WIDTH * VEC_ENV_OBS_HEIGHT) ///< Bytes of observation per lane.
+
+/**
+ * @brief Contents of an observation cell; where objects overlap the later one wins.
+ */
+typedef enum {
+    VEC_ENV_OBS_EMPTY,              ///< Nothing.
+    VEC_ENV_OBS_BLOCK,              ///< A block in play.
+    VEC_ENV_OBS_CAPSULE,            ///< A falling power-up capsule.
+    VEC_ENV_OBS_PADDLE,             ///< The paddle.
+    VEC_ENV_OBS_BALL                ///< A ball.
+} VecEnvCell;
+
+#define VEC_ENV_BALL(env, slot, lane) ((slot) * (env)->lanes + (lane)) ///< Index of a ball pool slot of a lane in the ball arrays.
+#define VEC_ENV_ROW(env, row, lane) ((row) * (env)->lanes + (lane))   ///< Index of a map row of a lane in block_rows.
+
+/**
+ * @brief Batch of games stepped in lockstep.
+ *
+ * Per-lane values are kept as structure of arrays, indexed by lane; balls
+ * and block rows have one array entry per slot or row and lane, so each
+ * slot or row is contiguous across the lanes. Block rows and the view
+ * change only on the engine path, which keeps them in the lane's
+ * GameContext too; block types and hits, the score, lives and the capsules
+ * live only in the contexts. A lane plays one map: it is done when the map is
+ * cleared or the last life is lost, and is not stepped again until it is
+ * reset.
+ */
+typedef struct {
+    int lanes;                      ///< Number of games.
+    uint32_t now;                   ///< Game time of the batch in ms.
+    GameContext* games;             ///< Engine state of each lane.
+    PowerupContext* powerups;       ///< Power-up state of each lane.
+    uint8_t* ball_x;                ///< Ball x of each slot of each lane (VEC_ENV_BALL).
+    uint8_t* ball_y;                ///< Ball y (world row).
+    int8_t* ball_dx;                ///< Ball horizontal velocity (see Ball).
+    int8_t* ball_dy;                ///< Ball vertical velocity.
+    uint8_t* ball_fx;               ///< Sub-pixel part of the ball x.
+    uint8_t* ball_fy;               ///< Sub-pixel part of the ball y.
+    uint16_t* ball_active;          ///< Slots in play of each lane (BallPool active mask).
+    uint8_t* paddle_x;              ///< Paddle x of each lane.
+    uint8_t* paddle_y;              ///< Paddle y of each lane (world row).
+    uint8_t* paddle_width;          ///< Paddle width of each lane.
+    uint16_t* block_rows;           ///< Active block bitmask of each map row of each lane (VEC_ENV_ROW), as in games.
+    uint8_t* block_bottom;          ///< First world row below the lowest block of each lane, 0 without blocks.
+    uint8_t* view_top;              ///< View position of each lane, as in games.
+    uint32_t* quiet_until;          ///< The lane may take the lane-wide pass at steps before this time.
+    uint8_t* wide;                  ///< Scratch: the lane takes the lane-wide pass in this step.
+    uint8_t* next_paddle_x;         ///< Scratch: paddle x after the action.
+    int32_t* reward;                ///< Points scored in the last step.
+    uint8_t* done;                  ///< The lane's game is over.
+    uint32_t* ticks;                ///< Steps played since the lane was reset.
+    uint64_t wide_steps;            ///< Lane steps taken by the lane-wide pass since vec_env_init().
+    uint8_t* obs;                   ///< VEC_ENV_OBS_SIZE cells per lane (VecEnvCell), NULL if not observed.
+} VecEnv;
+
+/**
+ * @brief Allocates a batch; every lane must be reset before it is stepped.
+ *
+ * @param env Environment to set up.
+ * @param lanes Number of games.
+ * @param observe Also produce observations after every step.
+ * @return 1 on success, 0 if out of memory.
+ */
+int vec_env_init(VecEnv* env, int lanes, int observe);
+
+/**
+ * @brief Frees a batch.
+ *
+ * @param env Environment set up by vec_env_init().
+ */
+void vec_env_free(VecEnv* env);
+
+/**
+ * @brief Starts a new game in one lane.
+ *
+ * @param env Environment.
+ * @param lane Lane to reset.
+ * @param map Map to play (from NUM_MAPS on, generated levels), below NUM_LEVELS.
+ * @param seed Game seed.
+ */
+void vec_env_reset(VecEnv* env, int lane, int map, uint32_t seed);
+
+/**
+ * @brief Advances every lane that is not done by one tick.
+ *
+ * @param env Environment.
+ * @param actions Slider value for each lane (1-100, 0 leaves the paddle where it is).
+ */
+void vec_env_step(VecEnv* env, const uint8_t* actions);
+
+/**
+ * @brief Copies a lane's balls into a ball pool.
+ *
+ * @param env Environment.
+ * @param lane Lane to read.
+ * @param pool Filled with the lane's balls.
+ */
+void vec_env_balls(const VecEnv* env, int lane, BallPool* pool);
+
+/**
+ * @brief Hash of a lane's game state, equal to replay_state_hash() of the same game run alone.
+ *
+ * @param env Environment.
+ * @param lane Lane to hash.
+ * @return State hash.
+ */
+uint32_t vec_env_hash(const VecEnv* env, int lane);
+
+#endif // VEC_ENV_H